@@ -0,0 +1,139 @@
+#include <fmt/base.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cxxopts.hpp>
+#include <filesystem>
+#include <magic_enum/magic_enum.hpp>
+#include <optional>
+#include <span>
+
+#include "batch.h"
+#include "chip8.h"
+#include "common.h"
+#include "instructions.h"
+
+namespace op = chip8::opcode;
+using chip8::regs;
+
+namespace {
+// Tight ALU loop with a call, skips and a sprite draw
+constexpr auto workload = op::instructions{
+    op::LD(regs::V0, 0x00),            // 200
+    op::LD(regs::V1, 0x01),            // 202
+    op::ADD(regs::V0, regs::V1),       // 204
+    op::CALL(0x0212),                  // 206
+    op::SE(regs::V0, 0x00),            // 208
+    op::JP(0x0204),                    // 20a
+    op::DRW(regs::V2, regs::V3, 0x5),  // 20c
+    op::JP(0x0200),                    // 20e
+    op::NOP(),                         // 210
+    op::XOR(regs::V2, regs::V0),       // 212
+    op::SHR(regs::V3, regs::V2),       // 214
+    op::ADD(regs::V4, 0x03),           // 216
+    op::SNE(regs::V4, 0x30),           // 218
+    op::LD_F(regs::V3),                // 21a
+    op::RET(),                         // 21c
+};
+
+struct result {
+  std::uint64_t count;
+  std::chrono::nanoseconds time;
+  chip8::cache_stats cache;
+};
+
+auto run(chip8::engine engine, const std::optional<std::filesystem::path>& rom,
+         std::uint64_t count) -> result {
+  auto emulator = chip8::chip8{};
+  emulator.set_engine(engine);
+
+  if (rom) {
+    emulator.load_rom(*rom);
+  } else {
+    emulator.load_program(workload);
+  }
+
+  auto begin = std::chrono::steady_clock::now();
+  emulator.exec_n(count);
+  auto end = std::chrono::steady_clock::now();
+
+  return {
+      .count = count, .time = end - begin, .cache = emulator.get_cache_stats()};
+}
+
+// count instructions spread over the lanes of a batch
+auto run_batch(const std::optional<std::filesystem::path>& rom,
+               std::uint64_t count) -> result {
+  constexpr auto LANES = 32UZ;
+
+  auto emulator = chip8::chip8{};
+
+  if (rom) {
+    emulator.load_rom(*rom);
+  } else {
+    emulator.load_program(workload);
+  }
+
+  auto lanes = chip8::batch<LANES>{};
+  lanes.load_rom(std::span(emulator.dump_memory()).subspan(0x200));
+
+  auto begin = std::chrono::steady_clock::now();
+  lanes.exec_n(count / LANES);
+  auto end = std::chrono::steady_clock::now();
+
+  return {.count = lanes.stats().vector + lanes.stats().scalar,
+          .time = end - begin,
+          .cache = {}};
+}
+}  // namespace
+
+auto main(int argc, char* argv[]) -> int {
+  auto args = cxxopts::Options("bench_chip8");
+
+  // clang-format off
+  args.add_options()
+    ("h,help", "Display help")
+    ("r,rom", "Benchmark ROM file", cxxopts::value<std::filesystem::path>())
+    ("n,count", "Instructions per engine", cxxopts::value<std::uint64_t>())
+  ;
+  // clang-format on
+
+  auto options = args.parse(argc, argv);
+
+  if (options.count("help") != 0) {
+    fmt::println(stderr, "{}", args.help());
+    return 1;
+  }
+
+  auto rom = std::optional<std::filesystem::path>{};
+  if (options.count("rom") != 0) {
+    rom = options["rom"].as<std::filesystem::path>();
+  }
+
+  auto count = std::uint64_t{50'000'000};
+  if (options.count("count") != 0) {
+    count = options["count"].as<std::uint64_t>();
+  }
+
+  for (auto engine : magic_enum::enum_values<chip8::engine>()) {
+    auto [executed, time, cache] = run(engine, rom, count);
+    auto seconds = std::chrono::duration<double>(time).count();
+
+    fmt::println("{:>10}  {:>8.3f} s  {:>8.2f} MIPS",
+                 magic_enum::enum_name(engine), seconds,
+                 as<double>(executed) / seconds / 1e6);
+
+    if (engine == chip8::engine::cached or engine == chip8::engine::jit) {
+      fmt::println("{:>10}  {:>8.2f} % block cache hits", "",
+                   cache.hit_rate() * 100);
+    }
+  }
+
+  auto [executed, time, cache] = run_batch(rom, count);
+  auto seconds = std::chrono::duration<double>(time).count();
+
+  fmt::println("{:>10}  {:>8.3f} s  {:>8.2f} MIPS", "batch", seconds,
+               as<double>(executed) / seconds / 1e6);
+
+  return 0;
+}
@@ -0,0 +1,48 @@
+# chip8_add_recompiled(<target> <rom> [PROFILE <vip|schip|xochip>])
+#
+# Recompiles a ROM into C++ with chip8-recomp and builds it as an executable,
+# with the quirks of PROFILE or vip when it is omitted
+function(chip8_add_recompiled TARGET ROM)
+  cmake_parse_arguments(PARSE_ARGV 2 ARG "" "PROFILE" "")
+
+  if(NOT ARG_PROFILE)
+    set(ARG_PROFILE vip)
+  endif()
+
+  get_filename_component(ROM_PATH ${ROM} ABSOLUTE)
+  set(GENERATED ${CMAKE_CURRENT_BINARY_DIR}/${TARGET}.cpp)
+
+  add_custom_command(
+    OUTPUT
+      ${GENERATED}
+    COMMAND
+      chip8-recomp
+        --rom ${ROM_PATH}
+        --profile ${ARG_PROFILE}
+        --output ${GENERATED}
+    DEPENDS
+      chip8-recomp
+      ${ROM_PATH}
+    COMMENT
+      "Recompiling ${ROM}..."
+  )
+
+  add_executable(${TARGET})
+
+  target_sources(
+    ${TARGET}
+  PRIVATE
+    ${GENERATED}
+  )
+
+  target_include_directories(
+    ${TARGET}
+  PRIVATE
+    $<TARGET_PROPERTY:chip8-core,SOURCE_DIR>
+  )
+
+  target_link_libraries(
+    ${TARGET}
+    chip8-raylib
+  )
+endfunction()
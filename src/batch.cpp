@@ -0,0 +1,550 @@
+#include "batch.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <utility>
+
+#include "common.h"
+#include "dispatch.h"
+#include "helpers.h"
+#include "quirks.h"
+#include "random.h"
+#include "screen.h"
+#include "semantics.h"
+
+// Runtime dispatch needs the target attribute and CPU detection of GCC and
+// Clang on x86-64
+#if defined(HK_CHIP8_AVX2) && !(defined(__x86_64__) && defined(__GNUC__))
+#undef HK_CHIP8_AVX2
+#endif
+
+namespace chip8 {
+namespace {
+constexpr auto LANE_SIZE = as<std::size_t>(MEMORY_SIZE);
+
+// value where mask is set and old elsewhere, without a branch so lane loops
+// compile to vector blends
+template <typename T>
+constexpr auto select(byte mask, T value, T old) -> T {
+  auto wide = as<T>(0 - as<T>(mask & 0x01));
+  return as<T>((value & wide) | (old & as<T>(~wide)));
+}
+
+#if defined(HK_CHIP8_AVX2)
+auto has_avx2() -> bool {
+  static const auto result = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+  }();
+
+  return result;
+}
+#endif
+}  // namespace
+
+template <std::size_t Lanes, quirks Q>
+batch<Lanes, Q>::batch()
+    : m_memory(Lanes * LANE_SIZE), m_table(&get_dispatch_table()) {
+  m_pc.fill(0x0200);
+  m_running.fill(0xff);
+
+  for (auto lane = 0UZ; lane < Lanes; lane++) {
+    auto addr = 0x0050_w;
+    for (const auto& digit : letters) {
+      for (const auto& data : digit) {
+        write(lane, addr++, data);
+      }
+    }
+
+    seed(lane, lane + 1);
+  }
+}
+
+template <std::size_t Lanes, quirks Q>
+auto batch<Lanes, Q>::load_rom(std::span<const byte> rom) -> void {
+  for (auto lane = 0UZ; lane < Lanes; lane++) {
+    load_rom(lane, rom);
+  }
+}
+
+template <std::size_t Lanes, quirks Q>
+auto batch<Lanes, Q>::load_rom(std::size_t lane, std::span<const byte> rom)
+    -> void {
+  auto size = std::min(rom.size(), LANE_SIZE - 0x200);
+  auto base = std::next(m_memory.begin(), as<std::ptrdiff_t>(lane * LANE_SIZE));
+
+  std::ranges::copy(rom.first(size), std::next(base, 0x200));
+}
+
+template <std::size_t Lanes, quirks Q>
+auto batch<Lanes, Q>::step() -> void {
+#if defined(HK_CHIP8_AVX2)
+  if (has_avx2()) {
+    step_avx2();
+    return;
+  }
+#endif
+
+  step_lanes();
+}
+
+#if defined(HK_CHIP8_AVX2)
+// Only this function is built for AVX2, the lane loops inlined into it
+// included. Anything it calls out of line, and every other function, stays
+// on the baseline ISA, so no shared inline code ends up needing AVX2.
+template <std::size_t Lanes, quirks Q>
+[[gnu::target("avx2")]] auto batch<Lanes, Q>::step_avx2() -> void {
+  step_lanes();
+}
+#endif
+
+template <std::size_t Lanes, quirks Q>
+[[gnu::always_inline]] inline auto batch<Lanes, Q>::step_lanes() -> void {
+  auto opcodes = lane_words{};
+
+  for (auto lane = 0UZ; lane < Lanes; lane++) {
+    auto pc = as<std::size_t>(m_pc[lane]);
+    const auto* mem = &m_memory[lane * LANE_SIZE];
+
+    // Straight from the arena unless the opcode straddles the end of memory
+    if (pc + 1 < LANE_SIZE) {
+      opcodes[lane] = as<word>((mem[pc] << 8) | mem[pc + 1]);
+    } else {
+      opcodes[lane] = fetch(lane);
+    }
+
+    opcodes[lane] &= as<word>(0 - (m_running[lane] & 0x01));
+    m_pc[lane] = select(m_running[lane], as<word>((m_pc[lane] + 2) & 0x0fff),
+                        m_pc[lane]);
+  }
+
+  m_stats.steps++;
+
+  // Lanes which haven't executed this step yet. The first of them leads a
+  // group of every lane on the same opcode, in lockstep the only group.
+  auto pending = m_running;
+
+  for (auto leader = 0UZ; leader < Lanes; leader++) {
+    if (pending[leader] == 0) {
+      continue;
+    }
+
+    auto mask = lane_mask{};
+    auto size = 0UZ;
+
+    for (auto lane = leader; lane < Lanes; lane++) {
+      mask[lane] =
+          pending[lane] & (opcodes[lane] == opcodes[leader] ? 0xff : 0x00);
+      pending[lane] &= as<byte>(~mask[lane]);
+      size += mask[lane] & 0x01;
+    }
+
+    const auto& inst = (*m_table)[opcodes[leader]];
+
+    if (exec_vector(inst, mask)) {
+      m_stats.vector += size;
+      continue;
+    }
+
+    m_stats.scalar += size;
+
+    for (auto lane = leader; lane < Lanes; lane++) {
+      if (mask[lane] != 0) {
+        exec_lane(lane, inst);
+      }
+    }
+  }
+}
+
+template <std::size_t Lanes, quirks Q>
+auto batch<Lanes, Q>::exec_n(std::uint64_t count) -> void {
+  for (; count > 0; count--) {
+    if (std::ranges::all_of(m_running, [](byte value) { return value == 0; })) {
+      return;
+    }
+
+    step();
+  }
+}
+
+template <std::size_t Lanes, quirks Q>
+auto batch<Lanes, Q>::tick() -> void {
+  for (auto lane = 0UZ; lane < Lanes; lane++) {
+    m_dt[lane] -= m_dt[lane] != 0 ? 1 : 0;
+    m_st[lane] -= m_st[lane] != 0 ? 1 : 0;
+  }
+}
+
+template <std::size_t Lanes, quirks Q>
+auto batch<Lanes, Q>::get(std::size_t lane, regs reg) const -> byte {
+  return m_v.at(std::to_underlying(reg)).at(lane);
+}
+
+template <std::size_t Lanes, quirks Q>
+auto batch<Lanes, Q>::get_i(std::size_t lane) const -> word {
+  return m_i.at(lane);
+}
+
+template <std::size_t Lanes, quirks Q>
+auto batch<Lanes, Q>::get_pc(std::size_t lane) const -> word {
+  return m_pc.at(lane);
+}
+
+template <std::size_t Lanes, quirks Q>
+auto batch<Lanes, Q>::get_dt(std::size_t lane) const -> byte {
+  return m_dt.at(lane);
+}
+
+template <std::size_t Lanes, quirks Q>
+auto batch<Lanes, Q>::read(std::size_t lane, word addr) const -> byte {
+  if (addr >= MEMORY_SIZE) {
+    return 0x00;
+  }
+
+  return m_memory[(lane * LANE_SIZE) + addr];
+}
+
+template <std::size_t Lanes, quirks Q>
+auto batch<Lanes, Q>::is_invalid(std::size_t lane) const -> bool {
+  return m_running.at(lane) == 0;
+}
+
+template <std::size_t Lanes, quirks Q>
+auto batch<Lanes, Q>::screen_hash(std::size_t lane) const -> std::uint64_t {
+  auto result = 0xcbf29ce484222325ULL;
+
+  for (auto bits : m_screens.at(lane)) {
+    for (auto idx = 0; idx < 8; idx++) {
+      result ^= (bits >> (idx * 8)) & 0xff;
+      result *= 0x100000001b3ULL;
+    }
+  }
+
+  return result;
+}
+
+template <std::size_t Lanes, quirks Q>
+auto batch<Lanes, Q>::press(std::size_t lane, keys key) -> void {
+  m_keyboards.at(lane).press(key);
+}
+
+template <std::size_t Lanes, quirks Q>
+auto batch<Lanes, Q>::release(std::size_t lane) -> void {
+  m_keyboards.at(lane).clear();
+}
+
+template <std::size_t Lanes, quirks Q>
+auto batch<Lanes, Q>::seed(std::size_t lane, std::uint64_t value) -> void {
+  // Same as xoshiro::seed()
+  for (auto& state : m_random) {
+    state.at(lane) = splitmix64(value);
+  }
+}
+
+template <std::size_t Lanes, quirks Q>
+auto batch<Lanes, Q>::stats() const -> const batch_stats& {
+  return m_stats;
+}
+
+template <std::size_t Lanes, quirks Q>
+auto batch<Lanes, Q>::fetch(std::size_t lane) const -> word {
+  // Same as chip8::read16()
+  auto pc = m_pc[lane];
+  if (pc > MEMORY_SIZE) {
+    return 0x0000;
+  }
+
+  return as<word>(read(lane, pc) << 8) | read(lane, as<word>(pc + 1));
+}
+
+template <std::size_t Lanes, quirks Q>
+auto batch<Lanes, Q>::write(std::size_t lane, word addr, byte data) -> void {
+  if (addr < MEMORY_SIZE) {
+    m_memory[(lane * LANE_SIZE) + addr] = data;
+  }
+}
+
+template <std::size_t Lanes, quirks Q>
+[[gnu::always_inline]] inline auto batch<Lanes, Q>::commit(
+    std::size_t reg, const lane_bytes& value, const lane_mask& mask) -> void {
+  auto& dst = m_v[reg];
+
+  for (auto lane = 0UZ; lane < Lanes; lane++) {
+    dst[lane] = select(mask[lane], value[lane], dst[lane]);
+  }
+}
+
+template <std::size_t Lanes, quirks Q>
+[[gnu::always_inline]] inline auto batch<Lanes, Q>::exec_vector(
+    const decoded_instruction& inst, const lane_mask& mask) -> bool {
+  auto reg_x = as<std::size_t>(std::to_underlying(inst.reg_x));
+  auto reg_y = as<std::size_t>(std::to_underlying(inst.reg_y));
+
+  // Copies, so VX, VY and VF aliasing each other can't get in the way
+  auto vx = m_v[reg_x];
+  auto vy = m_v[reg_y];
+
+  auto res = lane_bytes{};
+  auto flag = lane_bytes{};
+
+  // Conditional skips, cond is evaluated for every lane
+  auto skip_if = [&](auto cond) {
+    for (auto lane = 0UZ; lane < Lanes; lane++) {
+      auto taken = as<byte>(cond(lane) ? 0xff : 0x00) & mask[lane];
+      m_pc[lane] = as<word>(m_pc[lane] + (taken & 0x02));
+    }
+  };
+
+  switch (inst.op) {
+    case operation::CLS:
+      for (auto lane = 0UZ; lane < Lanes; lane++) {
+        for (auto& line : m_screens[lane]) {
+          line = select(mask[lane], std::uint64_t{}, line);
+        }
+      }
+      return true;
+    case operation::RET:
+      // Same as stack::pop(), an empty stack returns to 0x000
+      for (auto lane = 0UZ; lane < Lanes; lane++) {
+        auto depth = m_sp[lane];
+        auto top = depth != 0 ? m_stack[depth - 1][lane] : 0x0000_w;
+
+        m_sp[lane] = select(mask[lane], as<byte>(depth - (depth != 0 ? 1 : 0)),
+                            depth);
+        m_pc[lane] = select(mask[lane], top, m_pc[lane]);
+      }
+      return true;
+    case operation::CALL:
+      // Same as stack::push(), a full stack drops the return address
+      for (auto lane = 0UZ; lane < Lanes; lane++) {
+        auto depth = m_sp[lane];
+
+        if (mask[lane] != 0 and depth < STACK_SIZE) {
+          m_stack[depth][lane] = m_pc[lane];
+          m_sp[lane]++;
+        }
+
+        m_pc[lane] = select(mask[lane], inst.addr, m_pc[lane]);
+      }
+      return true;
+    case operation::JP:
+      for (auto lane = 0UZ; lane < Lanes; lane++) {
+        m_pc[lane] = select(mask[lane], inst.addr, m_pc[lane]);
+      }
+      return true;
+    case operation::SE_BYTE:
+      skip_if([&](auto lane) { return vx[lane] == inst.lo_byte; });
+      return true;
+    case operation::SNE_BYTE:
+      skip_if([&](auto lane) { return vx[lane] != inst.lo_byte; });
+      return true;
+    case operation::SE_REGS:
+      skip_if([&](auto lane) { return vx[lane] == vy[lane]; });
+      return true;
+    case operation::SNE_REGS:
+      skip_if([&](auto lane) { return vx[lane] != vy[lane]; });
+      return true;
+    case operation::LD_BYTE:
+      res.fill(inst.lo_byte);
+      commit(reg_x, res, mask);
+      return true;
+    case operation::ADD_BYTE:
+      for (auto lane = 0UZ; lane < Lanes; lane++) {
+        res[lane] = as<byte>(vx[lane] + inst.lo_byte);
+      }
+      commit(reg_x, res, mask);
+      return true;
+    case operation::LD_REGS:
+      commit(reg_x, vy, mask);
+      return true;
+    case operation::OR:
+    case operation::AND:
+    case operation::XOR:
+      for (auto lane = 0UZ; lane < Lanes; lane++) {
+        res[lane] = inst.op == operation::OR    ? vx[lane] | vy[lane]
+                    : inst.op == operation::AND ? vx[lane] & vy[lane]
+                                                : vx[lane] ^ vy[lane];
+      }
+      commit(reg_x, res, mask);
+
+      if constexpr (Q.vf_reset) {
+        commit(0xf, flag, mask);
+      }
+      return true;
+    case operation::ADD_REGS:
+      for (auto lane = 0UZ; lane < Lanes; lane++) {
+        res[lane] = as<byte>(vx[lane] + vy[lane]);
+        flag[lane] = res[lane] < vx[lane] ? 0x01 : 0x00;
+      }
+      commit(reg_x, res, mask);
+      commit(0xf, flag, mask);
+      return true;
+    case operation::SUB:
+      for (auto lane = 0UZ; lane < Lanes; lane++) {
+        res[lane] = as<byte>(vx[lane] - vy[lane]);
+        flag[lane] = vx[lane] >= vy[lane] ? 0x01 : 0x00;
+      }
+      commit(reg_x, res, mask);
+      commit(0xf, flag, mask);
+      return true;
+    case operation::SUBN:
+      for (auto lane = 0UZ; lane < Lanes; lane++) {
+        res[lane] = as<byte>(vy[lane] - vx[lane]);
+        flag[lane] = vy[lane] >= vx[lane] ? 0x01 : 0x00;
+      }
+      commit(reg_x, res, mask);
+      commit(0xf, flag, mask);
+      return true;
+    case operation::SHR:
+    case operation::SHL: {
+      const auto& src = Q.shift_vy ? vy : vx;
+
+      for (auto lane = 0UZ; lane < Lanes; lane++) {
+        if (inst.op == operation::SHR) {
+          res[lane] = as<byte>(src[lane] >> 1);
+          flag[lane] = src[lane] & 0x01;
+        } else {
+          res[lane] = as<byte>(src[lane] << 1);
+          flag[lane] = as<byte>(src[lane] >> 7);
+        }
+      }
+      commit(reg_x, res, mask);
+      commit(0xf, flag, mask);
+      return true;
+    }
+    case operation::LD_I:
+      for (auto lane = 0UZ; lane < Lanes; lane++) {
+        m_i[lane] = select(mask[lane], inst.addr, m_i[lane]);
+      }
+      return true;
+    case operation::ADD_I:
+      for (auto lane = 0UZ; lane < Lanes; lane++) {
+        m_i[lane] = select(mask[lane], as<word>(m_i[lane] + vx[lane]),
+                           m_i[lane]);
+      }
+      return true;
+    case operation::RND:
+      for (auto lane = 0UZ; lane < Lanes; lane++) {
+        auto state = std::array{m_random[0][lane], m_random[1][lane],
+                                m_random[2][lane], m_random[3][lane]};
+        auto value = xoshiro256(state[0], state[1], state[2], state[3]);
+
+        for (auto idx = 0UZ; idx < state.size(); idx++) {
+          m_random[idx][lane] =
+              select(mask[lane], state[idx], m_random[idx][lane]);
+        }
+
+        res[lane] = as<byte>(value >> 56) & inst.lo_byte;
+      }
+      commit(reg_x, res, mask);
+      return true;
+    case operation::LD_F:
+      for (auto lane = 0UZ; lane < Lanes; lane++) {
+        m_i[lane] = select(mask[lane], as<word>((vx[lane] % 0x0f) * 5),
+                           m_i[lane]);
+      }
+      return true;
+    case operation::LD_VX_DT:
+      commit(reg_x, m_dt, mask);
+      return true;
+    case operation::LD_DT:
+    case operation::LD_ST: {
+      auto& timer = inst.op == operation::LD_DT ? m_dt : m_st;
+
+      for (auto lane = 0UZ; lane < Lanes; lane++) {
+        timer[lane] = select(mask[lane], vx[lane], timer[lane]);
+      }
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+// What the handlers in semantics.h see of one lane
+template <std::size_t Lanes, quirks Q>
+struct batch<Lanes, Q>::lane_view {
+  batch* lanes;
+  std::size_t lane;
+
+  auto v(regs reg) -> byte& {
+    return lanes->m_v[std::to_underlying(reg)][lane];
+  }
+
+  auto i() -> word& { return lanes->m_i[lane]; }
+  auto pc() -> word& { return lanes->m_pc[lane]; }
+
+  [[nodiscard]] auto read(word addr) const -> byte {
+    return lanes->read(lane, addr);
+  }
+
+  auto write(word addr, byte data) -> void { lanes->write(lane, addr, data); }
+
+  auto draw(std::size_t row, std::uint64_t sprite) -> bool {
+    auto& line = lanes->m_screens[lane][row];
+    auto collision = (line & sprite) != 0;
+
+    line ^= sprite;
+    return collision;
+  }
+
+  [[nodiscard]] auto keyboard() const -> const ::chip8::keyboard& {
+    return lanes->m_keyboards[lane];
+  }
+
+  auto key_wait() -> std::optional<keys>& { return lanes->m_key_wait[lane]; }
+};
+
+template <std::size_t Lanes, quirks Q>
+auto batch<Lanes, Q>::exec_lane(std::size_t lane,
+                                const decoded_instruction& inst) -> void {
+  auto machine = lane_view{this, lane};
+
+  switch (inst.op) {
+    case operation::SYS:
+      semantics::sys(machine, inst.addr);
+      break;
+    case operation::JP_V0:
+      semantics::jp_v0<Q>(machine, inst.addr);
+      break;
+    case operation::DRW:
+      semantics::drw<Q>(machine, inst.reg_x, inst.reg_y, inst.nibble);
+      break;
+    case operation::SKP:
+      semantics::skp(machine, inst.reg_x);
+      break;
+    case operation::SKNP:
+      semantics::sknp(machine, inst.reg_x);
+      break;
+    case operation::LD_KEY:
+      semantics::ld_key(machine, inst.reg_x);
+      break;
+    case operation::LD_B:
+      semantics::bcd(machine, inst.reg_x);
+      break;
+    case operation::LD_I_VX:
+      semantics::st_regs<Q>(machine, inst.reg_x);
+      break;
+    case operation::LD_VX_I:
+      semantics::ld_regs<Q>(machine, inst.reg_x);
+      break;
+    default:
+      m_running[lane] = 0x00;
+      break;
+  }
+}
+
+template class batch<8>;
+template class batch<16>;
+template class batch<32>;
+template class batch<8, profiles::schip>;
+template class batch<16, profiles::schip>;
+template class batch<32, profiles::schip>;
+template class batch<8, profiles::xochip>;
+template class batch<16, profiles::xochip>;
+template class batch<32, profiles::xochip>;
+}  // namespace chip8
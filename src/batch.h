@@ -0,0 +1,118 @@
+#ifndef HK_CHIP8_BATCH_H
+#define HK_CHIP8_BATCH_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "common.h"
+#include "dispatch.h"
+#include "keyboard.h"
+#include "quirks.h"
+
+namespace chip8 {
+struct batch_stats {
+  std::uint64_t steps{};
+  // Lane instructions run by masked vector operations and one lane at a time
+  std::uint64_t vector{};
+  std::uint64_t scalar{};
+};
+
+// Lanes headless machines stepped in lockstep. V0-VF, I, PC and the timers
+// are kept as one array per field with an element per lane, so an opcode
+// every lane is running is a single vector operation across all of them.
+// Lanes which diverge are split into groups by opcode, each a masked vector
+// operation, and opcodes without a vector form run one lane at a time.
+template <std::size_t Lanes, quirks Q = profiles::vip>
+class batch {
+  static_assert(Lanes == 8 or Lanes == 16 or Lanes == 32);
+
+ public:
+  using lane_bytes = std::array<byte, Lanes>;
+  using lane_words = std::array<word, Lanes>;
+
+  explicit batch();
+
+  // Same ROM in every lane, or a ROM for a single lane
+  auto load_rom(std::span<const byte> rom) -> void;
+  auto load_rom(std::size_t lane, std::span<const byte> rom) -> void;
+
+  // One instruction in every lane which hasn't hit an invalid opcode
+  auto step() -> void;
+  auto exec_n(std::uint64_t count) -> void;
+
+  // One 60 Hz tick of every lane's delay and sound timers
+  auto tick() -> void;
+
+  // Lane API
+  [[nodiscard]] auto get(std::size_t lane, regs reg) const -> byte;
+  [[nodiscard]] auto get_i(std::size_t lane) const -> word;
+  [[nodiscard]] auto get_pc(std::size_t lane) const -> word;
+  [[nodiscard]] auto get_dt(std::size_t lane) const -> byte;
+  [[nodiscard]] auto read(std::size_t lane, word addr) const -> byte;
+  [[nodiscard]] auto is_invalid(std::size_t lane) const -> bool;
+
+  // Same hash as chip8::screen_hash()
+  [[nodiscard]] auto screen_hash(std::size_t lane) const -> std::uint64_t;
+
+  auto press(std::size_t lane, keys key) -> void;
+  auto release(std::size_t lane) -> void;
+
+  // RND draws from a per lane xoshiro256**, a lane seeded with a value
+  // draws the same bytes as chip8 seeded with it
+  auto seed(std::size_t lane, std::uint64_t value) -> void;
+
+  [[nodiscard]] auto stats() const -> const batch_stats&;
+
+ private:
+  // 0xff for lanes taking part in a vector operation, 0x00 otherwise
+  using lane_mask = std::array<byte, Lanes>;
+
+  static constexpr auto STACK_SIZE = 0x10UZ;
+
+  // Body of step(), built once for the baseline ISA and once for AVX2 hosts
+  auto step_lanes() -> void;
+  auto step_avx2() -> void;
+
+  [[nodiscard]] auto fetch(std::size_t lane) const -> word;
+  auto write(std::size_t lane, word addr, byte data) -> void;
+
+  // Vector path, false if the operation only has a scalar implementation
+  auto exec_vector(const decoded_instruction& inst, const lane_mask& mask)
+      -> bool;
+  auto commit(std::size_t reg, const lane_bytes& value, const lane_mask& mask)
+      -> void;
+
+  // Scalar path for the rest, through the handlers chip8 runs too
+  struct lane_view;
+  auto exec_lane(std::size_t lane, const decoded_instruction& inst) -> void;
+
+  std::array<lane_bytes, 0x10> m_v{};
+  lane_words m_i{};
+  lane_words m_pc{};
+  lane_bytes m_dt{};
+  lane_bytes m_st{};
+  lane_mask m_running{};
+
+  // Return addresses, entry m_sp - 1 is the top of a lane's stack
+  std::array<lane_words, STACK_SIZE> m_stack{};
+  lane_bytes m_sp{};
+
+  // Lane memories back to back
+  std::vector<byte> m_memory;
+
+  std::array<std::array<std::uint64_t, HEIGHT>, Lanes> m_screens{};
+  std::array<keyboard, Lanes> m_keyboards{};
+  std::array<std::optional<keys>, Lanes> m_key_wait{};
+  // xoshiro256** state, one array per state word
+  std::array<std::array<std::uint64_t, Lanes>, 4> m_random{};
+
+  const dispatch_table* m_table;
+  batch_stats m_stats;
+};
+}  // namespace chip8
+
+#endif
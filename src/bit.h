@@ -54,6 +54,17 @@ class integer_iterator {
 
 using byte_iterator = integer_iterator<byte>;
 
+// Bit order reversed, the most significant bit becomes the least
+constexpr auto mirror(byte value) -> byte {
+  auto result = byte{};
+
+  for (auto idx = 0; idx < 8; idx++) {
+    result = as<byte>((result << 1) | ((value >> idx) & 1));
+  }
+
+  return result;
+}
+
 template <std::integral T>
 auto begin(T& value) -> integer_iterator<T> {
   return integer_iterator<byte>(value, 0);
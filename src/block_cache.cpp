@@ -0,0 +1,148 @@
+#include "block_cache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <utility>
+
+#include "common.h"
+#include "dispatch.h"
+#include "helpers.h"
+
+namespace chip8 {
+namespace {
+auto ends_block(operation op) -> bool {
+  switch (op) {
+    case operation::RET:
+    case operation::JP:
+    case operation::CALL:
+    case operation::SE_BYTE:
+    case operation::SNE_BYTE:
+    case operation::SE_REGS:
+    case operation::SNE_REGS:
+    case operation::JP_V0:
+    case operation::DRW:
+    case operation::SKP:
+    case operation::SKNP:
+    case operation::LD_KEY:
+    case operation::INVALID:
+      return true;
+    default:
+      return false;
+  }
+}
+}  // namespace
+
+auto cache_stats::hit_rate() const -> double {
+  auto total = hits + misses;
+  return total != 0 ? as<double>(hits) / as<double>(total) : 0.0;
+}
+
+auto block_cache::insert(word pc, const memory& mem) -> basic_block& {
+  auto& block = m_blocks.at(pc);
+
+  m_stats.misses++;
+
+  const auto& table = m_table != nullptr ? *m_table : get_dispatch_table();
+  block = std::make_unique<basic_block>(translate(pc, mem, table));
+  m_starts.push_back(pc);
+  attach_native(*block, mem);
+
+  for (auto addr = block->start; addr < block->end; addr++) {
+    m_code_pages.set(addr / PAGE_SIZE);
+  }
+
+  return *block;
+}
+
+auto block_cache::attach_native(basic_block& block, const memory& mem) const
+    -> void {
+  auto entry = std::ranges::lower_bound(m_native, block.start, {},
+                                        &native_entry::start);
+
+  if (entry == m_native.end() or entry->start != block.start or
+      entry->size != block.ops.size()) {
+    return;
+  }
+
+  // Code next to the block may have changed, the block itself must not have
+  auto bytes = std::span{mem}.subspan(block.start, block.end - block.start);
+
+  if (std::ranges::equal(bytes, entry->source)) {
+    block.native = entry->code;
+  }
+}
+
+auto block_cache::translate(word pc, const memory& mem,
+                            const dispatch_table& table) -> basic_block {
+  auto block = basic_block{.start = pc, .end = pc, .ops = {}};
+
+  while (block.ops.size() < MAX_BLOCK) {
+    // Same as chip8::fetch(), the byte past the end of memory reads as zero
+    auto upper = as<word>(mem.at(pc) << 8);
+    auto lower = as<word>(pc + 1 < MEMORY_SIZE ? mem.at(pc + 1) : 0x00);
+
+    const auto& inst = table.at(upper | lower);
+    block.ops.push_back(inst);
+
+    pc += 2;
+    block.end = std::min<word>(pc, MEMORY_SIZE);
+
+    // Don't let a block wrap around the end of memory
+    if (ends_block(inst.op) or pc >= MEMORY_SIZE) {
+      break;
+    }
+  }
+
+  return block;
+}
+
+auto block_cache::invalidate_page(std::size_t page) -> void {
+  auto begin = page * PAGE_SIZE;
+  auto end = begin + PAGE_SIZE;
+
+  auto covers = [&](word start) {
+    const auto& block = m_blocks.at(start);
+    return block->start < end and begin < block->end;
+  };
+
+  auto [first, last] = std::ranges::remove_if(m_starts, [&](word start) {
+    if (not covers(start)) {
+      return false;
+    }
+
+    m_blocks.at(start).reset();
+    m_stats.invalidations++;
+    return true;
+  });
+
+  m_starts.erase(first, last);
+  m_code_pages.reset(page);
+  m_epoch++;
+}
+
+auto block_cache::clear() -> void {
+  for (auto start : m_starts) {
+    m_blocks.at(start).reset();
+  }
+
+  m_starts.clear();
+  m_code_pages.reset();
+  m_epoch++;
+}
+
+auto block_cache::set_table(const dispatch_table& table) -> void {
+  m_table = &table;
+  m_native.clear();
+  clear();
+}
+
+auto block_cache::set_native(std::span<const native_entry> entries) -> void {
+  m_native.assign(entries.begin(), entries.end());
+  std::ranges::sort(m_native, {}, &native_entry::start);
+  clear();
+}
+
+auto block_cache::stats() const -> const cache_stats& { return m_stats; }
+}  // namespace chip8
@@ -0,0 +1,117 @@
+#ifndef HK_CHIP8_BLOCK_CACHE_H
+#define HK_CHIP8_BLOCK_CACHE_H
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "common.h"
+#include "dispatch.h"
+
+namespace chip8 {
+class chip8;
+
+// Block compiled to host code, returns the number of instructions executed
+using native_block = auto (*)(chip8* cpu, byte* regs, word* reg_i, word* pc)
+    -> std::uint32_t;
+
+// Host code for the block starting at start, size instructions long and
+// translated from the bytes in source
+struct native_entry {
+  word start;
+  std::size_t size;
+  std::span<const byte> source;
+  native_block code;
+};
+
+// Straight-line run of pre-decoded instructions ending at a branch, skip,
+// draw or key wait
+struct basic_block {
+  word start{};
+  word end{};
+  std::vector<decoded_instruction> ops;
+
+  std::uint32_t runs{};
+  native_block native{};
+};
+
+struct cache_stats {
+  std::uint64_t hits{};
+  std::uint64_t misses{};
+  std::uint64_t invalidations{};
+  std::uint64_t compiled{};
+
+  [[nodiscard]] auto hit_rate() const -> double;
+};
+
+class block_cache {
+ public:
+  static constexpr auto PAGE_SIZE = 0x10UZ;
+  static constexpr auto MAX_BLOCK = 0x20UZ;
+
+  // Cached block starting at pc, translated from mem on a miss
+  auto lookup(word pc, const memory& mem) -> basic_block& {
+    if (const auto& block = m_blocks.at(pc)) {
+      m_stats.hits++;
+      return *block;
+    }
+
+    return insert(pc, mem);
+  }
+
+  // Drop every block covering addr
+  auto invalidate(word addr) -> void {
+    if (m_code_pages.test(addr / PAGE_SIZE)) {
+      invalidate_page(addr / PAGE_SIZE);
+    }
+  }
+
+  auto clear() -> void;
+
+  // Handlers new blocks are decoded with, drops every block and native entry
+  auto set_table(const dispatch_table& table) -> void;
+
+  // Host code attached to blocks whenever they are translated from the same
+  // bytes, again after an invalidation too. Drops every block.
+  auto set_native(std::span<const native_entry> entries) -> void;
+
+  // Decode the block starting at pc without caching it
+  static auto translate(word pc, const memory& mem,
+                        const dispatch_table& table = get_dispatch_table())
+      -> basic_block;
+
+  // Changes whenever a block is dropped
+  [[nodiscard]] auto epoch() const -> std::uint64_t { return m_epoch; }
+  [[nodiscard]] auto epoch_ptr() const -> const std::uint64_t* {
+    return &m_epoch;
+  }
+
+  auto count_compiled() -> void { m_stats.compiled++; }
+
+  [[nodiscard]] auto stats() const -> const cache_stats&;
+
+ private:
+  auto insert(word pc, const memory& mem) -> basic_block&;
+  auto attach_native(basic_block& block, const memory& mem) const -> void;
+
+  auto invalidate_page(std::size_t page) -> void;
+
+  std::array<std::unique_ptr<basic_block>, MEMORY_SIZE> m_blocks{};
+  std::vector<word> m_starts;
+  std::bitset<MEMORY_SIZE / PAGE_SIZE> m_code_pages;
+
+  // Sorted by start
+  std::vector<native_entry> m_native;
+
+  // Default profile's table when unset
+  const dispatch_table* m_table{};
+
+  std::uint64_t m_epoch{};
+  cache_stats m_stats;
+};
+}  // namespace chip8
+
+#endif
@@ -2,30 +2,41 @@
 
 #include <fmt/base.h>
 #include <fmt/format.h>
-#include <raylib.h>
 
 #include <algorithm>
+#include <array>
 #include <cstdint>
 #include <filesystem>
-#include <fstream>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <magic_enum/magic_enum.hpp>
+#include <memory>
+#include <optional>
+#include <random>
 #include <ranges>
+#include <span>
 #include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
 
-#include "bit.h"
 #include "common.h"
+#include "dispatch.h"
+#include "frontend.h"
 #include "helpers.h"
 #include "instructions.h"
 #include "parser.h"
+#include "random.h"
+#include "rom.h"
 #include "screen.h"
+#include "semantics.h"
 
 namespace chip8 {
 chip8::chip8() {
+  auto device = std::random_device{};
+  seed((std::uint64_t{device()} << 32) | device());
+
   auto addr = 0x0050_w;
   for (const auto& digit : letters) {
     for (const auto& data : digit) {
@@ -34,33 +45,111 @@ chip8::chip8() {
   }
 }
 
-chip8::chip8(screen_tag_t /* unused */) : chip8() { init_raylib(); }
-
-chip8::~chip8() { close_raylib(); }
+chip8::~chip8() = default;
 
 auto chip8::get(regs reg) -> byte& {
-  return m_registers.at(std::to_underlying(reg));
+  return m_state.registers.at(std::to_underlying(reg));
 }
 
 auto chip8::get(regs reg) const -> byte {
-  return m_registers.at(std::to_underlying(reg));
+  return m_state.registers.at(std::to_underlying(reg));
 }
 
 auto chip8::dt_tick() -> void {
-  if (m_dt != 0) {
-    m_dt--;
+  if (m_state.dt != 0) {
+    m_state.dt--;
   }
 }
 
 auto chip8::st_tick() -> void {
-  if (m_st != 0) {
-    m_st--;
+  if (m_state.st != 0) {
+    m_state.st--;
   }
 }
 
-auto chip8::get_random() -> byte { return m_r = randomness(random_device); }
+auto chip8::get_random() -> byte {
+  if (m_random) {
+    return m_state.r = m_random->next();
+  }
+
+  auto& [s0, s1, s2, s3] = m_state.rng;
+
+  // The high bits are the strongest, like xoshiro::next()
+  return m_state.r = as<byte>(xoshiro256(s0, s1, s2, s3) >> 56);
+}
+
+auto chip8::seed(std::uint64_t value) -> void {
+  if (m_random) {
+    m_random->seed(value);
+    return;
+  }
+
+  for (auto& word : m_state.rng) {
+    word = splitmix64(value);
+  }
+}
+
+auto chip8::set_random(std::unique_ptr<random_source> value) -> void {
+  m_random = std::move(value);
+}
+
+auto chip8::save_state() const -> const machine_state& { return m_state; }
+
+auto chip8::load_state(const machine_state& state) -> void {
+  // Cached code only goes out of date on pages where memory differs, rewind
+  // loads a state every frame and mostly changes none
+  constexpr auto PAGE = block_cache::PAGE_SIZE;
+
+  for (auto page = 0UZ; page < MEMORY_SIZE; page += PAGE) {
+    auto before = std::span{m_state.memory}.subspan(page, PAGE);
+    auto after = std::span{state.memory}.subspan(page, PAGE);
+
+    if (not std::ranges::equal(before, after)) {
+      m_cache.invalidate(as<word>(page));
+    }
+  }
+
+  m_state = state;
+
+  // The whole screen needs presenting again
+  m_state.screen.mark_dirty();
+}
+
+auto chip8::set_rewind(std::size_t frames, std::size_t bytes) -> void {
+  m_rewind = std::make_unique<rewind_buffer>(frames, bytes);
+  m_rewind->push(m_state);
+}
+
+auto chip8::rewind() -> bool {
+  auto state = m_rewind ? m_rewind->step_back() : std::nullopt;
+
+  if (not state) {
+    return false;
+  }
+
+  // Frontends only send changes, so the keys held are the ones held now, not
+  // the ones back then. Key changes still to come move back with the
+  // instruction count.
+  auto held = m_state.keyboard;
+  auto elapsed = m_state.instructions - state->instructions;
+
+  load_state(*state);
+
+  m_state.keyboard = held;
+  m_state.key_parked = false;
+
+  for (auto& event : m_events) {
+    event.at -= elapsed;
+  }
+
+  return true;
+}
 
-auto chip8::dump_memory() -> memory& { return m_memory; }
+auto chip8::dump_memory() -> memory& {
+  // The caller may write anywhere
+  m_cache.clear();
+  return m_state.memory;
+}
 
 auto chip8::print_memory(word begin, word end) const -> void {
   fmt::print(" hex  ");
@@ -97,11 +186,11 @@ auto chip8::print_registers() const -> void {
   fmt::print("VC: {:02x}\tVD: {:02x}\t", get(regs::VC), get(regs::VD));
   fmt::print("VE: {:02x}\tVF: {:02x}\n", get(regs::VE), get(regs::VF));
 
-  fmt::print("PC: {:04x}\t I: {:04x}\n", m_pc, m_i);
-  fmt::print("SP: {:02x}\t\t R: {:02x}\n", m_stack.size(), m_r);
-  fmt::print("DT: {:02x}\t\tST: {:02x}\n", m_dt, m_st);
+  fmt::print("PC: {:04x}\t I: {:04x}\n", m_state.pc, m_state.i);
+  fmt::print("SP: {:02x}\t\t R: {:02x}\n", m_state.stack.size(), m_state.r);
+  fmt::print("DT: {:02x}\t\tST: {:02x}\n", m_state.dt, m_state.st);
 
-  auto key = m_keyboard.key();
+  auto key = m_state.keyboard.key();
   fmt::print("Key: {}\n", key ? as<std::string>(*key) : "NONE");
 }
 
@@ -214,7 +303,7 @@ auto chip8::invalid_opcode(word opcode) const -> std::string {
 }
 
 auto chip8::print_opcode(word addr) const -> void {
-  if (addr == m_pc) {
+  if (addr == m_state.pc) {
     fmt::print(
         "{:03x} [=]\t"
         "{:04x}\t"
@@ -234,7 +323,7 @@ auto chip8::read(word addr) const -> byte {
     return 0x00;
   }
 
-  return m_memory.at(addr);
+  return m_state.memory.at(addr);
 }
 
 auto chip8::write(word addr, byte data) -> void {
@@ -242,7 +331,8 @@ auto chip8::write(word addr, byte data) -> void {
     return;
   }
 
-  m_memory.at(addr) = data;
+  m_state.memory.at(addr) = data;
+  m_cache.invalidate(addr);
 }
 
 auto chip8::read16(word addr) const -> word {
@@ -268,53 +358,118 @@ auto chip8::write16(word addr, word data) -> void {
   write(addr + 1, lower);
 }
 
-auto chip8::is_invalid() const -> bool { return m_is_invalid_state; }
+auto chip8::is_invalid() const -> bool { return m_state.invalid; }
 
-auto chip8::fetch() -> word {
-  auto opcode = read16(m_pc);
+auto chip8::waiting_for_key() const -> bool { return m_state.key_parked; }
 
-  m_pc += 2;
-  m_pc &= 0x0fff;
+auto chip8::halted() const -> bool { return m_state.invalid or m_state.key_parked; }
 
-  return opcode;
+auto chip8::compare(const chip8& other) const -> std::optional<std::string> {
+  for (auto idx = 0UZ; idx < m_state.registers.size(); idx++) {
+    if (m_state.registers.at(idx) != other.m_state.registers.at(idx)) {
+      return fmt::format("V{:X}: {:02x} != {:02x}", idx, m_state.registers.at(idx),
+                         other.m_state.registers.at(idx));
+    }
+  }
+
+  if (m_state.i != other.m_state.i) {
+    return fmt::format("I: {:04x} != {:04x}", m_state.i, other.m_state.i);
+  }
+
+  if (m_state.pc != other.m_state.pc) {
+    return fmt::format("PC: {:04x} != {:04x}", m_state.pc, other.m_state.pc);
+  }
+
+  if (m_state.dt != other.m_state.dt or m_state.st != other.m_state.st) {
+    return fmt::format("DT/ST: {:02x}/{:02x} != {:02x}/{:02x}", m_state.dt, m_state.st,
+                       other.m_state.dt, other.m_state.st);
+  }
+
+  auto stack = m_state.stack.array();
+  auto other_stack = other.m_state.stack.array();
+  auto depth = as<std::ptrdiff_t>(m_state.stack.size());
+
+  if (m_state.stack.size() != other.m_state.stack.size() or
+      not std::equal(stack.begin(), std::next(stack.begin(), depth),
+                     other_stack.begin())) {
+    return fmt::format("Stack: {} != {} entries", m_state.stack.size(),
+                       other.m_state.stack.size());
+  }
+
+  for (auto addr = 0UZ; addr < m_state.memory.size(); addr++) {
+    if (m_state.memory.at(addr) != other.m_state.memory.at(addr)) {
+      return fmt::format("Memory {:03x}: {:02x} != {:02x}", addr,
+                         m_state.memory.at(addr), other.m_state.memory.at(addr));
+    }
+  }
+
+  for (auto idx_y = 0UZ; idx_y < HEIGHT; idx_y++) {
+    for (auto idx_x = 0UZ; idx_x < WIDTH; idx_x++) {
+      if (m_state.screen[idx_x, idx_y] != other.m_state.screen[idx_x, idx_y]) {
+        return fmt::format("Screen ({}, {}) differs", idx_x, idx_y);
+      }
+    }
+  }
+
+  return std::nullopt;
+}
+
+auto chip8::press(keys key) -> void {
+  m_state.keyboard.press(key);
+  m_state.key_parked = false;
+}
+
+auto chip8::release() -> void {
+  m_state.keyboard.clear();
+  m_state.key_parked = false;
 }
 
-auto chip8::init_raylib() -> void {
-  if (not is_raylib()) {
-    SetTraceLogLevel(LOG_WARNING);
-    InitWindow(WIDTH * PIXEL, HEIGHT * PIXEL, "hellokartikey - CHIP8 Emulator");
+auto chip8::schedule(key_event event) -> void {
+  auto pos = std::ranges::upper_bound(m_events, event.at, {}, &key_event::at);
+  m_events.insert(pos, event);
+}
 
-    BeginDrawing();
+auto chip8::apply_events() -> void {
+  while (not m_events.empty() and m_events.front().at <= m_state.instructions) {
+    auto event = m_events.front();
+    m_events.pop_front();
 
-    ClearBackground(BG_COLOR);
+    if (event.down == m_state.keyboard.is_pressed(event.key)) {
+      continue;
+    }
 
-    EndDrawing();
+    if (event.down) {
+      m_state.keyboard.press(event.key);
+    } else {
+      m_state.keyboard.clear(event.key);
+    }
 
-    m_raylib = true;
+    m_state.key_parked = false;
   }
 }
 
-auto chip8::close_raylib() -> void {
-  if (is_raylib()) {
-    CloseWindow();
-    m_raylib = false;
+auto chip8::until_event() const -> std::uint64_t {
+  if (m_events.empty()) {
+    return std::numeric_limits<std::uint64_t>::max();
   }
+
+  return m_events.front().at - m_state.instructions;
 }
 
-auto chip8::is_raylib() const -> bool { return m_raylib; }
+auto chip8::fetch() -> word {
+  auto opcode = read16(m_state.pc);
 
-auto chip8::check_close() -> bool {
-  if (m_should_close) {
-    return true;
-  }
-  return m_should_close = WindowShouldClose();
+  m_state.pc += 2;
+  m_state.pc &= 0x0fff;
+
+  return opcode;
 }
 
 auto chip8::start_addr() const -> word { return m_start_addr; }
 
 auto chip8::load_program(opcode::instructions program) -> void {
   auto addr = start_addr();
-  m_pc = addr;
+  m_state.pc = addr;
 
   for (const auto& opcode : program) {
     write16(addr, opcode);
@@ -322,7 +477,267 @@ auto chip8::load_program(opcode::instructions program) -> void {
   }
 }
 
-auto chip8::exec() -> void {
+auto chip8::get_engine() const -> engine { return m_engine; }
+
+auto chip8::set_engine(engine value) -> void {
+  if (value != engine::reference) {
+    m_dispatch = &get_dispatch_table(m_profile);
+  }
+
+  if (value == engine::jit and not m_jit) {
+    m_jit = std::make_unique<jit>(get_quirks(m_profile));
+  }
+
+  m_engine = value;
+}
+
+auto chip8::get_profile() const -> profile { return m_profile; }
+
+auto chip8::set_profile(profile value) -> void {
+  m_profile = value;
+  m_dispatch = &get_dispatch_table(value);
+
+  // Cached and compiled blocks carry the old profile's handlers
+  m_cache.set_table(*m_dispatch);
+
+  if (m_jit) {
+    m_jit = std::make_unique<jit>(get_quirks(value));
+  }
+}
+
+auto chip8::exec() -> void { exec_n(1); }
+
+auto chip8::get_cache_stats() const -> const cache_stats& {
+  return m_cache.stats();
+}
+
+auto chip8::code_epoch() const -> std::uint64_t { return m_cache.epoch(); }
+
+auto chip8::install_native(std::span<const native_entry> blocks) -> void {
+  m_cache.set_native(blocks);
+}
+
+auto chip8::exec_table() -> void {
+  const auto& inst = (*m_dispatch)[fetch()];
+  inst.exec(*this, inst);
+}
+
+template <quirks Q>
+auto chip8::exec_threaded(std::uint64_t& count) -> void {
+#if defined(__GNUC__)
+  // NOLINTBEGIN(cppcoreguidelines-avoid-goto)
+  // Indexed by operation
+  static const auto labels = std::array<void*, 36>{
+      &&sys, &&cls, &&ret, &&jp, &&call, &&se_byte, &&sne_byte, &&se_regs,
+      &&ld_byte, &&add_byte, &&ld_regs, &&or_, &&and_, &&xor_, &&add_regs,
+      &&sub, &&shr, &&subn, &&shl, &&sne_regs, &&ld_i, &&jp_v0, &&rnd, &&drw,
+      &&skp, &&sknp, &&ld_dt, &&ld_key, &&st_dt, &&ld_st, &&add_i, &&ld_font,
+      &&bcd, &&st_regs, &&ld_regs_i, &&invalid,
+  };
+
+  static_assert(labels.size() == magic_enum::enum_count<operation>());
+
+  const auto* inst = static_cast<const decoded_instruction*>(nullptr);
+
+#define DISPATCH()                              \
+  do {                                          \
+    if (count == 0) {                           \
+      return;                                   \
+    }                                           \
+    count--;                                    \
+    inst = &(*m_dispatch)[fetch()];             \
+    goto* labels[std::to_underlying(inst->op)]; \
+  } while (false)
+
+  if (halted()) {
+    return;
+  }
+
+  DISPATCH();
+
+sys:
+  sys(inst->addr);
+  DISPATCH();
+cls:
+  cls();
+  DISPATCH();
+ret:
+  ret();
+  DISPATCH();
+jp:
+  jp(inst->addr);
+  DISPATCH();
+call:
+  call(inst->addr);
+  DISPATCH();
+se_byte:
+  se(inst->reg_x, inst->lo_byte);
+  DISPATCH();
+sne_byte:
+  sne(inst->reg_x, inst->lo_byte);
+  DISPATCH();
+se_regs:
+  se(inst->reg_x, inst->reg_y);
+  DISPATCH();
+ld_byte:
+  ld(inst->reg_x, inst->lo_byte);
+  DISPATCH();
+add_byte:
+  add(inst->reg_x, inst->lo_byte);
+  DISPATCH();
+ld_regs:
+  ld(inst->reg_x, inst->reg_y);
+  DISPATCH();
+or_:
+  or_<Q>(inst->reg_x, inst->reg_y);
+  DISPATCH();
+and_:
+  and_<Q>(inst->reg_x, inst->reg_y);
+  DISPATCH();
+xor_:
+  xor_<Q>(inst->reg_x, inst->reg_y);
+  DISPATCH();
+add_regs:
+  add(inst->reg_x, inst->reg_y);
+  DISPATCH();
+sub:
+  sub(inst->reg_x, inst->reg_y);
+  DISPATCH();
+shr:
+  shr<Q>(inst->reg_x, inst->reg_y);
+  DISPATCH();
+subn:
+  subn(inst->reg_x, inst->reg_y);
+  DISPATCH();
+shl:
+  shl<Q>(inst->reg_x, inst->reg_y);
+  DISPATCH();
+sne_regs:
+  sne(inst->reg_x, inst->reg_y);
+  DISPATCH();
+ld_i:
+  ld_i(inst->addr);
+  DISPATCH();
+jp_v0:
+  jp_v0<Q>(inst->addr);
+  DISPATCH();
+rnd:
+  rnd(inst->reg_x, inst->lo_byte);
+  DISPATCH();
+drw:
+  drw<Q>(inst->reg_x, inst->reg_y, inst->nibble);
+  DISPATCH();
+skp:
+  skp(inst->reg_x);
+  DISPATCH();
+sknp:
+  sknp(inst->reg_x);
+  DISPATCH();
+ld_dt:
+  ld_dt(inst->reg_x);
+  DISPATCH();
+ld_key:
+  ld_key(inst->reg_x);
+  if (halted()) {
+    return;
+  }
+  DISPATCH();
+st_dt:
+  st_dt(inst->reg_x);
+  DISPATCH();
+ld_st:
+  ld_st(inst->reg_x);
+  DISPATCH();
+add_i:
+  add_i(inst->reg_x);
+  DISPATCH();
+ld_font:
+  ld_font(inst->reg_x);
+  DISPATCH();
+bcd:
+  bcd(inst->reg_x);
+  DISPATCH();
+st_regs:
+  st_regs<Q>(inst->reg_x);
+  DISPATCH();
+ld_regs_i:
+  ld_regs<Q>(inst->reg_x);
+  DISPATCH();
+invalid:
+  invalid(inst->opcode);
+  return;
+
+#undef DISPATCH
+  // NOLINTEND(cppcoreguidelines-avoid-goto)
+#else
+  for (; count > 0 and not halted(); count--) {
+    exec_table();
+  }
+#endif
+}
+
+auto chip8::exec_cached(std::uint64_t& count) -> void {
+  while (count > 0 and not halted()) {
+    exec_block(m_cache.lookup(m_state.pc, m_state.memory), count);
+  }
+}
+
+auto chip8::exec_native(std::uint64_t& count) -> void {
+  auto compile = m_engine == engine::jit;
+
+  while (count > 0 and not halted()) {
+    auto& block = m_cache.lookup(m_state.pc, m_state.memory);
+
+    if (compile and not block.native and
+        ++block.runs == jit::HOT_THRESHOLD) {
+      auto available = m_jit->available();
+      block.native = m_jit->compile(block, m_cache.epoch_ptr());
+
+      if (not block.native and available) {
+        // Out of code space, start over. If the host stopped allowing code
+        // to be written, earlier blocks go too and everything is interpreted
+        // from here on.
+        m_cache.clear();
+        m_jit->reset();
+        continue;
+      }
+
+      if (block.native) {
+        m_cache.count_compiled();
+      }
+    }
+
+    // Native blocks always run to the end, leave the tail to the interpreter
+    if (block.native and block.ops.size() <= count) {
+      count -= block.native(this, m_state.registers.data(), &m_state.i, &m_state.pc);
+    } else {
+      exec_block(block, count);
+    }
+  }
+}
+
+auto chip8::exec_block(const basic_block& block, std::uint64_t& count)
+    -> void {
+  const auto* ops = block.ops.data();
+  auto size = std::min<std::uint64_t>(block.ops.size(), count);
+  auto epoch = m_cache.epoch();
+
+  for (auto idx = 0UZ; idx < size; idx++) {
+    // A handler writing to memory may drop this very block
+    auto inst = ops[idx];
+
+    m_state.pc = address(m_state.pc + 2);
+    inst.exec(*this, inst);
+    count--;
+
+    if (m_cache.epoch() != epoch or halted()) {
+      break;
+    }
+  }
+}
+
+template <quirks Q>
+auto chip8::exec_reference() -> void {
   auto parsed = parsed_instruction(fetch());
 
   auto opcode = parsed.get_opcode();
@@ -372,13 +787,13 @@ auto chip8::exec() -> void {
           ld(reg_x, reg_y);
           break;
         case 0x1:
-          or_(reg_x, reg_y);
+          or_<Q>(reg_x, reg_y);
           break;
         case 0x2:
-          and_(reg_x, reg_y);
+          and_<Q>(reg_x, reg_y);
           break;
         case 0x3:
-          xor_(reg_x, reg_y);
+          xor_<Q>(reg_x, reg_y);
           break;
         case 0x4:
           add(reg_x, reg_y);
@@ -387,13 +802,13 @@ auto chip8::exec() -> void {
           sub(reg_x, reg_y);
           break;
         case 0x6:
-          shr(reg_x, reg_y);
+          shr<Q>(reg_x, reg_y);
           break;
         case 0x7:
           subn(reg_x, reg_y);
           break;
         case 0xe:
-          shl(reg_x, reg_y);
+          shl<Q>(reg_x, reg_y);
           break;
         default:
           invalid(opcode);
@@ -407,13 +822,13 @@ auto chip8::exec() -> void {
       ld_i(addr);
       break;
     case 0xb:
-      jp_v0(addr);
+      jp_v0<Q>(addr);
       break;
     case 0xc:
       rnd(reg_x, lo_byte);
       break;
     case 0xd:
-      drw(reg_x, reg_y, parsed.get_nibble(0));
+      drw<Q>(reg_x, reg_y, parsed.get_nibble(0));
       break;
     case 0xe:
       switch (lo_byte) {
@@ -451,10 +866,10 @@ auto chip8::exec() -> void {
           bcd(reg_x);
           break;
         case 0x55:
-          st_regs(reg_x);
+          st_regs<Q>(reg_x);
           break;
         case 0x65:
-          ld_regs(reg_x);
+          ld_regs<Q>(reg_x);
           break;
         default:
           invalid(opcode);
@@ -465,52 +880,272 @@ auto chip8::exec() -> void {
       invalid(opcode);
       break;
   }
-
-  update_peripherals();
 }
 
 auto chip8::exec_n(std::uint64_t count) -> void {
-  for (; count > 0 and not is_invalid(); count--) {
-    exec();
+  // Instruction clocked timers tick and key changes apply between runs, at
+  // the exact instruction
+  while (count > 0 and not is_invalid()) {
+    apply_events();
+
+    auto chunk = std::min({count, m_state.timer.until_tick(), until_event()});
+
+    // Parked on LD Vx, K the time passes without running anything, it
+    // still counts as executed like the spinning it replaces
+    auto executed = m_state.key_parked ? chunk : exec_engine(chunk);
+
+    m_state.instructions += executed;
+    count -= executed;
+
+    if (m_state.timer.advance(executed)) {
+      tick_timers();
+    }
+
+    if (executed < chunk and not m_state.key_parked) {
+      return;
+    }
   }
 }
 
+auto chip8::exec_engine(std::uint64_t count) -> std::uint64_t {
+  auto remaining = count;
+
+  switch (m_engine) {
+    case engine::reference:
+      with_quirks(m_profile, [this, &remaining]<quirks Q>() {
+        for (; remaining > 0 and not halted(); remaining--) {
+          exec_reference<Q>();
+        }
+      });
+      break;
+    case engine::table:
+      for (; remaining > 0 and not halted(); remaining--) {
+        exec_table();
+      }
+      break;
+    case engine::threaded:
+      with_quirks(m_profile, [this, &remaining]<quirks Q>() {
+        exec_threaded<Q>(remaining);
+      });
+      break;
+    case engine::cached:
+      exec_cached(remaining);
+      break;
+    case engine::jit:
+    case engine::recompiled:
+      exec_native(remaining);
+      break;
+  }
+
+  return count - remaining;
+}
+
+auto chip8::tick_timers() -> void {
+  dt_tick();
+  st_tick();
+  m_state.timer.tick();
+}
+
+auto chip8::exec_frame() -> void {
+  poll_input();
+
+  auto budget = ipf();
+
+  // Skipping is only exact while nothing can tick or change keys in the
+  // middle of a frame
+  auto quiet = m_state.timer.per_frame() and until_event() >= budget;
+  auto loop = quiet ? find_idle_loop() : std::nullopt;
+
+  if (loop) {
+    // Whole iterations would only reload the delay timer, run the remainder
+    // so the frame still ends where it would have
+    if (loop->reg and budget >= loop->length) {
+      get(*loop->reg) = m_state.dt;
+    }
+
+    // Skipped iterations still count as executed
+    m_state.instructions += budget - (budget % loop->length);
+    budget %= loop->length;
+    m_idle_frames++;
+  }
+
+  exec_n(budget);
+
+  if (m_state.timer.per_frame()) {
+    tick_timers();
+  }
+
+  m_state.frames++;
+
+  if (m_rewind) {
+    m_rewind->push(m_state);
+  }
+
+  m_audio->tone(m_state.st != 0);
+  present();
+}
+
 auto chip8::exec_all() -> void {
   while (not is_invalid()) {
-    if (check_close()) {
+    if (m_display->closed()) {
       return;
     }
 
-    exec();
+    if (m_input->rewinding() and rewind()) {
+      m_audio->tone(false);
+      present();
+      continue;
+    }
+
+    exec_frame();
   }
 
   debug_shell();
 }
 
-auto chip8::update_peripherals() -> void {
-  m_timer.tick();
+auto chip8::ipf() const -> std::uint64_t { return m_ipf; }
+
+auto chip8::set_ipf(std::uint64_t count) -> void {
+  m_ipf = std::max<std::uint64_t>(count, 1);
+}
+
+auto chip8::timer_period() const -> std::uint64_t { return m_state.timer.period(); }
 
-  if (is_raylib()) {
-    m_keyboard.check();
-    m_screen.draw_screen();
+auto chip8::set_timer_period(std::uint64_t count) -> void {
+  m_state.timer.set_period(count);
+}
+
+auto chip8::timer_ticks() const -> std::uint64_t { return m_state.timer.ticks(); }
+
+auto chip8::frames() const -> std::uint64_t { return m_state.frames; }
+
+auto chip8::idle_frames() const -> std::uint64_t { return m_idle_frames; }
+
+auto chip8::instructions() const -> std::uint64_t { return m_state.instructions; }
+
+auto chip8::screen_hash() const -> std::uint64_t { return m_state.screen.hash(); }
+
+auto chip8::state_hash() const -> std::uint64_t {
+  // FNV-1a like screen::hash(), which covers the pixels
+  auto result = m_state.screen.hash();
+  auto mix = [&result](std::uint64_t value) {
+    result ^= value;
+    result *= 0x100000001b3ULL;
+  };
+
+  for (auto value : m_state.registers) {
+    mix(value);
+  }
+
+  mix(m_state.i);
+  mix(m_state.pc);
+  mix(m_state.dt);
+  mix(m_state.st);
+
+  auto stack = m_state.stack.array();
+  mix(m_state.stack.size());
+
+  for (auto idx = 0UZ; idx < m_state.stack.size(); idx++) {
+    mix(stack.at(idx));
+  }
+
+  for (auto value : m_state.memory) {
+    mix(value);
+  }
+
+  return result;
+}
+
+auto chip8::find_idle_loop() const -> std::optional<idle_loop> {
+  // JP to itself never gets anywhere
+  if (read16(m_state.pc) == (0x1000 | m_state.pc)) {
+    return idle_loop{.length = 1, .reg = std::nullopt};
+  }
+
+  if (m_state.dt == 0) {
+    return std::nullopt;
+  }
+
+  // LD Vx, DT; SE Vx, 0; JP back, the program counter can be at any of them
+  for (auto offset : {0, 2, 4}) {
+    auto head = address(m_state.pc - offset);
+    auto load = read16(head);
+    auto reg = as<byte>((load >> 8) & 0x0f);
+
+    if ((load & 0xf0ff) != 0xf007 or
+        read16(address(head + 2)) != (0x3000 | (reg << 8)) or
+        read16(address(head + 4)) != (0x1000 | head)) {
+      continue;
+    }
+
+    // About to compare a register which won't keep the loop going
+    if (offset == 2 and get(as<regs>(reg)) == 0) {
+      return std::nullopt;
+    }
+
+    return idle_loop{.length = 3, .reg = as<regs>(reg)};
+  }
+
+  return std::nullopt;
+}
+
+auto chip8::set_display(display& value) -> void { m_display = &value; }
+
+auto chip8::set_input(input& value) -> void { m_input = &value; }
+
+auto chip8::set_audio(audio& value) -> void { m_audio = &value; }
+
+auto chip8::poll_input() -> void {
+  m_polled.clear();
+  m_input->poll(m_polled);
+
+  // Keys pressed in this batch, and the ones among them already released
+  auto pressed = keyboard{};
+  auto tapped = keyboard{};
+
+  for (auto event : m_polled) {
+    event.at = m_state.instructions;
+
+    // A key tapped between two polls stays down for a frame so the program
+    // gets to see it, anything after that for the key waits too
+    if (tapped.is_pressed(event.key)) {
+      event.at += m_ipf;
+    } else if (event.down) {
+      pressed.press(event.key);
+    } else if (pressed.is_pressed(event.key)) {
+      event.at += m_ipf;
+      tapped.press(event.key);
+    }
+
+    schedule(event);
+  }
+
+  apply_events();
+}
+
+auto chip8::present() -> void {
+  if (m_show) {
+    m_display->present(m_state.screen);
+    m_state.screen.mark_clean();
   }
 }
 
 auto chip8::load_rom(const std::filesystem::path& file) -> void {
-  if (not std::filesystem::is_regular_file(file)) {
+  auto rom = read_rom(file);
+
+  if (not rom) {
     fmt::print(stderr, "Invalid rom file path\n");
     return;
   }
 
-  std::ifstream rom{file, std::ios::binary | std::ios::ate};
-
-  auto end = rom.tellg();
-  auto rom_data = std::vector<char>(end);
+  load_rom(*rom);
+}
 
-  rom.seekg(std::ios::beg);
-  rom.read(rom_data.data(), end);
+auto chip8::load_rom(std::span<const byte> rom) -> void {
+  auto size = std::min(rom.size(), m_state.memory.size() - 0x200);
 
-  std::ranges::copy(rom_data, std::next(m_memory.begin(), 0x200));
+  std::ranges::copy(rom.first(size), std::next(m_state.memory.begin(), 0x200));
+  m_cache.clear();
 }
 
 auto chip8::debug_shell() -> void {
@@ -521,7 +1156,7 @@ auto chip8::debug_shell() -> void {
       break;
     }
 
-    fmt::print("{:03x}> ", m_pc);
+    fmt::print("{:03x}> ", m_state.pc);
 
     auto line = std::string{};
     std::getline(std::cin, line);
@@ -557,9 +1192,9 @@ auto chip8::debug_shell() -> void {
     } else if (sub_command == "screen") {
       debug_screen(cmd);
     } else if (sub_command == "clear") {
-      m_screen.clear();
+      m_state.screen.clear();
     } else if (sub_command == "full") {
-      m_screen.full();
+      m_state.screen.full();
     } else if (sub_command == "pixel") {
       debug_pixel(cmd);
     } else if (sub_command == "rom") {
@@ -570,7 +1205,7 @@ auto chip8::debug_shell() -> void {
       fmt::print(stderr, "Invalid command...\n");
     }
 
-    m_screen.draw_screen();
+    present();
   }
 
   fmt::print("exiting...\n");
@@ -597,15 +1232,15 @@ auto chip8::debug_set_regs(std::stringstream& cmd) -> void {
   if (magic_enum::enum_contains<regs>(reg_str)) {
     get(as<regs>(reg_str)) = addr;
   } else if (reg_str == "PC") {
-    m_pc = address(addr);
+    m_state.pc = address(addr);
   } else if (reg_str == "I") {
-    m_i = address(addr);
+    m_state.i = address(addr);
   } else if (reg_str == "R") {
-    m_r = addr;
+    m_state.r = addr;
   } else if (reg_str == "DT") {
-    m_dt = addr;
+    m_state.dt = addr;
   } else if (reg_str == "ST") {
-    m_st = addr;
+    m_state.st = addr;
   } else {
     fmt::print(stderr, "Invalid register\n");
   }
@@ -618,10 +1253,10 @@ auto chip8::debug_push(std::stringstream& cmd) -> void {
     cmd >> std::hex >> addr;
   }
 
-  m_stack.push(address(addr));
+  m_state.stack.push(address(addr));
 }
 
-auto chip8::debug_pop() -> void { fmt::print("{:03x}\n", m_stack.pop()); }
+auto chip8::debug_pop() -> void { fmt::print("{:03x}\n", m_state.stack.pop()); }
 
 auto chip8::debug_step(std::stringstream& cmd) -> void {
   std::uint64_t count = 1;
@@ -634,12 +1269,12 @@ auto chip8::debug_step(std::stringstream& cmd) -> void {
 }
 
 auto chip8::debug_stk() -> void {
-  if (m_stack.empty()) {
+  if (m_state.stack.empty()) {
     fmt::print("|     |\n");
   }
 
-  for (auto idx = m_stack.size(); idx > 0; idx--) {
-    fmt::print("| {:03x} |\n", m_stack.array().at(idx - 1));
+  for (auto idx = m_state.stack.size(); idx > 0; idx--) {
+    fmt::print("| {:03x} |\n", m_state.stack.array().at(idx - 1));
   }
 
   fmt::print("+-----+\n");
@@ -681,7 +1316,7 @@ auto chip8::debug_help(std::stringstream& /*cmd*/) -> void {
       "  rnd                  Generate a random byte\n"
       "  press [key|NONE]     Press a key\n"
       "  display              Display screen state in terminal\n"
-      "  screen [on|off]      Turn on raylib powered screen\n"
+      "  screen [on|off]      Turn screen updates on or off\n"
       "  clear                Clear all pixels on screen\n"
       "  full                 Fill all pixels on screen\n"
       "  pixel [x] [y]        Toggle pixel at (x, y)\n"
@@ -691,7 +1326,7 @@ auto chip8::debug_help(std::stringstream& /*cmd*/) -> void {
 }
 
 auto chip8::debug_dasm(std::stringstream& cmd) -> void {
-  auto begin = m_pc;
+  auto begin = m_state.pc;
 
   if (begin >= 0x0004) {
     begin -= 0x0004;
@@ -723,11 +1358,11 @@ auto chip8::debug_scr() -> void {
   fmt::print(
       "+----------------------------------------------------------------+\n");
 
-  for (const auto& row : m_screen) {
+  for (const auto& row : m_state.screen) {
     fmt::print("|");
 
-    for (auto col = 0; col < row.size(); col++) {
-      if (row[col]) {
+    for (auto col = 0; col < WIDTH; col++) {
+      if (((row >> col) & 1) != 0) {
         fmt::print("#");
       } else {
         fmt::print(" ");
@@ -745,16 +1380,16 @@ auto chip8::debug_random() -> void { fmt::print("{:02x}\n", get_random()); }
 
 auto chip8::debug_screen(std::stringstream& cmd) -> void {
   if (cmd.eof()) {
-    init_raylib();
+    m_show = true;
   }
 
   auto arg = std::string{};
   cmd >> arg;
 
   if (arg == "on") {
-    init_raylib();
+    m_show = true;
   } else if (arg == "off") {
-    close_raylib();
+    m_show = false;
   }
 }
 
@@ -770,7 +1405,7 @@ auto chip8::debug_pixel(std::stringstream& cmd) -> void {
   cmd >> idx_y;
 
   if (idx_x < WIDTH and idx_y < HEIGHT) {
-    m_screen[idx_x, idx_y] = ~m_screen[idx_x, idx_y];
+    m_state.screen[idx_x, idx_y] = ~m_state.screen[idx_x, idx_y];
   }
 }
 
@@ -795,52 +1430,77 @@ auto chip8::debug_press(std::stringstream& cmd) -> void {
   cmd >> key;
 
   if (key == "NONE") {
-    m_keyboard.clear();
+    release();
     return;
   }
 
   if (magic_enum::enum_contains<keys>(key)) {
-    m_keyboard.press(as<keys>(key));
+    press(as<keys>(key));
   } else {
     fmt::print(stderr, "Invalid key!\n");
   }
 }
 
-auto chip8::sys(word /*addr*/) -> void {
+// What the handlers in semantics.h see of the interpreter
+struct chip8::view {
+  chip8* cpu;
+
+  auto v(regs reg) -> byte& { return cpu->get(reg); }
+  auto i() -> word& { return cpu->m_state.i; }
+  auto pc() -> word& { return cpu->m_state.pc; }
+
+  [[nodiscard]] auto read(word addr) const -> byte { return cpu->read(addr); }
+  auto write(word addr, byte data) -> void { cpu->write(addr, data); }
+
+  auto draw(std::size_t row, std::uint64_t sprite) -> bool {
+    return cpu->m_state.screen.draw(row, sprite);
+  }
+
+  [[nodiscard]] auto keyboard() const -> const ::chip8::keyboard& {
+    return cpu->m_state.keyboard;
+  }
+
+  auto key_wait() -> std::optional<keys>& { return cpu->m_state.key_wait; }
+};
+
+auto chip8::sys(word addr) -> void {
   fmt::print(stderr, "SYS addr not implemented by this emulator\n");
+
+  auto machine = view{this};
+  semantics::sys(machine, addr);
 }
 
 auto chip8::invalid(word opcode) -> void {
   fmt::print(stderr, "Unsupported opcode {:04x}\n", opcode);
-  m_is_invalid_state = true;
+  m_state.invalid = true;
 }
 
-auto chip8::cls() -> void { m_screen.clear(); }
+auto chip8::cls() -> void { m_state.screen.clear(); }
 
-auto chip8::ret() -> void { m_pc = m_stack.pop(); }
+auto chip8::ret() -> void { m_state.pc = m_state.stack.pop(); }
 
-auto chip8::jp(word addr) -> void { m_pc = address(addr); };
+auto chip8::jp(word addr) -> void { m_state.pc = address(addr); };
 
 auto chip8::call(word addr) -> void {
-  m_stack.push(m_pc);
-  m_pc = addr;
+  m_state.stack.push(m_state.pc);
+  m_state.pc = addr;
 }
 
 auto chip8::se(regs reg, byte value) -> void {
   if (get(reg) == value) {
-    m_pc += 2;
+    m_state.pc += 2;
   }
 }
 
 auto chip8::se(regs reg1, regs reg2) -> void {
   if (get(reg1) == get(reg2)) {
-    m_pc += 2;
+    m_state.pc += 2;
   }
 }
 
 auto chip8::sne(regs reg, byte value) -> void {
   if (get(reg) != value) {
-    m_pc += 2;
+    m_state.pc += 2;
   }
 }
 
@@ -856,19 +1516,31 @@ auto chip8::add(regs dst, regs src) -> void {
 
 auto chip8::ld(regs dst, regs src) -> void { get(dst) = get(src); }
 
+template <quirks Q>
 auto chip8::or_(regs dst, regs src) -> void {
   get(dst) |= get(src);
-  get(regs::VF) = 0x00;
+
+  if constexpr (Q.vf_reset) {
+    get(regs::VF) = 0x00;
+  }
 }
 
+template <quirks Q>
 auto chip8::and_(regs dst, regs src) -> void {
   get(dst) &= get(src);
-  get(regs::VF) = 0x00;
+
+  if constexpr (Q.vf_reset) {
+    get(regs::VF) = 0x00;
+  }
 }
 
+template <quirks Q>
 auto chip8::xor_(regs dst, regs src) -> void {
   get(dst) ^= get(src);
-  get(regs::VF) = 0x00;
+
+  if constexpr (Q.vf_reset) {
+    get(regs::VF) = 0x00;
+  }
 }
 
 auto chip8::sub(regs dst, regs src) -> void {
@@ -877,7 +1549,12 @@ auto chip8::sub(regs dst, regs src) -> void {
   get(regs::VF) = as<byte>(set_flag);
 }
 
+template <quirks Q>
 auto chip8::shr(regs dst, regs src) -> void {
+  if constexpr (not Q.shift_vy) {
+    src = dst;
+  }
+
   const bool set_flag = (get(src) & 0x01) != 0;
   get(dst) = get(src) >> 1;
   get(regs::VF) = as<byte>(set_flag);
@@ -889,7 +1566,12 @@ auto chip8::subn(regs dst, regs src) -> void {
   get(regs::VF) = as<byte>(set_flag);
 }
 
+template <quirks Q>
 auto chip8::shl(regs dst, regs src) -> void {
+  if constexpr (not Q.shift_vy) {
+    src = dst;
+  }
+
   const bool set_flag = (get(src) & 0x80) != 0x00;
   get(dst) = get(src) << 1;
   get(regs::VF) = as<byte>(set_flag);
@@ -897,123 +1579,88 @@ auto chip8::shl(regs dst, regs src) -> void {
 
 auto chip8::sne(regs reg1, regs reg2) -> void {
   if (get(reg1) != get(reg2)) {
-    m_pc += 2;
+    m_state.pc += 2;
   }
 }
 
-auto chip8::ld_i(word addr) -> void { m_i = address(addr); }
+auto chip8::ld_i(word addr) -> void { m_state.i = address(addr); }
 
-auto chip8::jp_v0(word addr) -> void { m_pc = address(addr + get(regs::V0)); }
+template <quirks Q>
+auto chip8::jp_v0(word addr) -> void {
+  auto machine = view{this};
+  semantics::jp_v0<Q>(machine, addr);
+}
 
 auto chip8::rnd(regs reg, byte value) -> void {
   get(reg) = get_random() & value;
 }
 
+template <quirks Q>
 auto chip8::drw(regs reg_x, regs reg_y, byte count) -> void {
-  auto idx_x = get(reg_x);
-  auto idx_y = get(reg_y);
-
-  auto iter = m_screen.pixel_iter(idx_x, idx_y);
-  auto addr = m_i;
-
-  get(regs::VF) = 0x00;
-
-  while (count-- != 0) {
-    auto data = read(addr++);
-    for (auto i = begin(data); i != end(data); i++) {
-      auto old_value = as<bool>(*iter);
-      auto new_value = as<bool>(*i ^ *iter);
-      auto value = *iter;
-
-      iter++;
-
-      if (old_value and not new_value) {
-        get(regs::VF) = 0x01;
-      }
-
-      value = new_value;
-    }
-  }
+  auto machine = view{this};
+  semantics::drw<Q>(machine, reg_x, reg_y, count);
 }
 
 auto chip8::bcd(regs reg) -> void {
-  auto data = get(reg);
-
-  auto one = data % 10;
-
-  data /= 10;
-  auto ten = data % 10;
-
-  data /= 10;
-  auto hun = data % 10;
-
-  auto addr = m_i;
-  write(addr++, hun);
-  write(addr++, ten);
-  write(addr++, one);
+  auto machine = view{this};
+  semantics::bcd(machine, reg);
 }
 
+template <quirks Q>
 auto chip8::st_regs(regs reg) -> void {
-  namespace views = std::views;
-
-  for (auto idx : views::iota(0, as<int>(reg) + 1)) {
-    write(m_i++, get(as<regs>(idx)));
-  }
+  auto machine = view{this};
+  semantics::st_regs<Q>(machine, reg);
 }
 
+template <quirks Q>
 auto chip8::ld_regs(regs reg) -> void {
-  namespace views = std::ranges::views;
-
-  for (auto idx : views::iota(0, as<int>(reg) + 1)) {
-    get(as<regs>(idx)) = read(m_i++);
-  }
+  auto machine = view{this};
+  semantics::ld_regs<Q>(machine, reg);
 }
 
 auto chip8::skp(regs reg) -> void {
-  if (m_keyboard.is_pressed(as<keys>(get(reg)))) {
-    m_pc += 2;
-  }
+  auto machine = view{this};
+  semantics::skp(machine, reg);
 }
 
 auto chip8::sknp(regs reg) -> void {
-  if (not m_keyboard.is_pressed(as<keys>(get(reg)))) {
-    m_pc += 2;
-  }
+  auto machine = view{this};
+  semantics::sknp(machine, reg);
 }
 
-auto chip8::ld_dt(regs reg) -> void { get(reg) = m_dt; }
+auto chip8::ld_dt(regs reg) -> void { get(reg) = m_state.dt; }
 
-auto chip8::st_dt(regs reg) -> void { m_dt = get(reg); }
+auto chip8::st_dt(regs reg) -> void { m_state.dt = get(reg); }
 
 auto chip8::ld_key(regs reg) -> void {
-  auto key = m_keyboard.key();
-
-  while (not key) {
-    update_peripherals();
-
-    key = m_keyboard.key();
-
-    if (check_close()) {
-      return;
-    }
-  }
-
-  get(reg) = as<byte>(*key);
+  // Until the keyboard changes this instruction would do the same thing
+  // again, so the CPU parks on it and only runs it again after the next key
+  // event
+  auto machine = view{this};
+  m_state.key_parked = semantics::ld_key(machine, reg);
+}
 
-  while (key) {
-    update_peripherals();
+auto chip8::ld_st(regs reg) -> void { m_state.st = get(reg); }
 
-    key = m_keyboard.key();
+auto chip8::add_i(regs reg) -> void { m_state.i += get(reg); }
 
-    if (check_close()) {
-      return;
-    }
-  }
-}
+auto chip8::ld_font(regs reg) -> void { m_state.i = (get(reg) % 0x0f) * 5; }
 
-auto chip8::ld_st(regs reg) -> void { m_st = get(reg); }
+// The dispatch tables in dispatch.cpp call these directly
+#define INSTANTIATE_QUIRKS(Q)                          \
+  template auto chip8::or_<Q>(regs, regs)->void;       \
+  template auto chip8::and_<Q>(regs, regs)->void;      \
+  template auto chip8::xor_<Q>(regs, regs)->void;      \
+  template auto chip8::shr<Q>(regs, regs)->void;       \
+  template auto chip8::shl<Q>(regs, regs)->void;       \
+  template auto chip8::jp_v0<Q>(word)->void;           \
+  template auto chip8::drw<Q>(regs, regs, byte)->void; \
+  template auto chip8::st_regs<Q>(regs)->void;         \
+  template auto chip8::ld_regs<Q>(regs)->void
 
-auto chip8::add_i(regs reg) -> void { m_i += get(reg); }
+INSTANTIATE_QUIRKS(profiles::vip);
+INSTANTIATE_QUIRKS(profiles::schip);
+INSTANTIATE_QUIRKS(profiles::xochip);
 
-auto chip8::ld_font(regs reg) -> void { m_i = (get(reg) % 0x0f) * 5; }
+#undef INSTANTIATE_QUIRKS
 }  // namespace chip8
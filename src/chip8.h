@@ -1,21 +1,53 @@
 #ifndef HK_CHIP8_CHIP8_H
 #define HK_CHIP8_CHIP8_H
 
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <filesystem>
-#include <random>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
 
+#include "block_cache.h"
 #include "common.h"
+#include "dispatch.h"
+#include "frontend.h"
 #include "instructions.h"
+#include "jit.h"
 #include "keyboard.h"
+#include "machine_state.h"
+#include "quirks.h"
+#include "random.h"
+#include "rewind.h"
 #include "screen.h"
 #include "stack.h"
 #include "timer.h"
 
 namespace chip8 {
+enum class engine : byte {
+  // Nested switch over the opcode nibbles
+  reference,
+  // Pre-decoded handler and operands for every opcode
+  table,
+  // Handlers jump straight to the next handler using computed goto
+  threaded,
+  // Straight-line runs of pre-decoded instructions cached by address
+  cached,
+  // Hot cached blocks compiled to x86-64, same as cached on other hosts
+  jit,
+  // Blocks installed by a chip8-recomp build, same as cached otherwise
+  recompiled,
+};
+
 class chip8 {
+  template <quirks Q>
+  friend struct dispatch;
+
  public:
   explicit chip8();
-  explicit chip8(screen_tag_t /* unused */);
   ~chip8();
 
   explicit chip8(const chip8&) = delete;
@@ -31,7 +63,24 @@ class chip8 {
   auto dt_tick() -> void;
   auto st_tick() -> void;
 
+  // RND API, xoshiro256** seeded from std::random_device unless seeded or
+  // replaced. Only the built in generator is part of the machine state.
   [[nodiscard]] auto get_random() -> byte;
+  auto seed(std::uint64_t value) -> void;
+  auto set_random(std::unique_ptr<random_source> value) -> void;
+
+  // Save state API, a snapshot is a plain copy. Loading keeps the engine,
+  // profile, frontends and scheduled key events.
+  [[nodiscard]] auto save_state() const -> const machine_state&;
+  auto load_state(const machine_state& state) -> void;
+
+  // Rewind API, off until enabled. Keeps up to frames of the most recent
+  // frames in at most bytes of memory.
+  auto set_rewind(std::size_t frames, std::size_t bytes) -> void;
+
+  // Go back to the frame before, false when there is none left. Keys held
+  // stay held.
+  auto rewind() -> bool;
 
   // Memory API
   auto dump_memory() -> memory&;
@@ -44,13 +93,27 @@ class chip8 {
 
   [[nodiscard]] auto is_invalid() const -> bool;
 
+  // Parked on LD Vx, K until the keyboard changes. Instructions and frames
+  // still pass, they just don't run anything.
+  [[nodiscard]] auto waiting_for_key() const -> bool;
+
+  // First difference in registers, memory or screen, if any
+  [[nodiscard]] auto compare(const chip8& other) const
+      -> std::optional<std::string>;
+
+  // Keyboard API
+  auto press(keys key) -> void;
+  auto release() -> void;
+
+  // Apply a key change at an exact instruction boundary, once instructions()
+  // reaches event.at. Changes with the same count keep their order.
+  auto schedule(key_event event) -> void;
+
  private:
   auto fetch() -> word;
 
-  auto init_raylib() -> void;
-  auto close_raylib() -> void;
-  [[nodiscard]] auto is_raylib() const -> bool;
-  [[nodiscard]] auto check_close() -> bool;
+  // Invalid or parked, engines stop running instructions
+  [[nodiscard]] auto halted() const -> bool;
 
  public:
   // Program API
@@ -58,21 +121,106 @@ class chip8 {
 
   auto load_program(opcode::instructions program) -> void;
 
-  // Execute a single instruction
+  // Interpreter engine API
+  [[nodiscard]] auto get_engine() const -> engine;
+  auto set_engine(engine value) -> void;
+
+  // Variant quirks, the default is the COSMAC VIP
+  [[nodiscard]] auto get_profile() const -> profile;
+  auto set_profile(profile value) -> void;
+
+  [[nodiscard]] auto get_cache_stats() const -> const cache_stats&;
+
+  // Changes whenever memory holding cached code is written
+  [[nodiscard]] auto code_epoch() const -> std::uint64_t;
+
+  // Attach host code to blocks of the loaded program, blocks whose bytes no
+  // longer match an entry's source are interpreted. Changing the profile
+  // drops the entries.
+  auto install_native(std::span<const native_entry> blocks) -> void;
+
+  // Execute a single instruction, same as exec_n(1)
   auto exec() -> void;
 
   // Execute count instructions
   auto exec_n(std::uint64_t count = 1) -> void;
 
-  // Execute continously
+  // Execute a single frame: poll input, run the instruction budget, tick the
+  // timers and present the screen once
+  auto exec_frame() -> void;
+
+  // Execute frames continously
   auto exec_all() -> void;
 
-  auto update_peripherals() -> void;
+  // Frame scheduler API
+  [[nodiscard]] auto ipf() const -> std::uint64_t;
+  auto set_ipf(std::uint64_t count) -> void;
+
+  // DT and ST tick once per frame by default, or once every count
+  // instructions when count isn't zero. Either way it is virtual time, wall
+  // clock pacing is up to the frontend.
+  [[nodiscard]] auto timer_period() const -> std::uint64_t;
+  auto set_timer_period(std::uint64_t count) -> void;
+  [[nodiscard]] auto timer_ticks() const -> std::uint64_t;
+
+  // Frames run so far and how many of them were skipped as idle
+  [[nodiscard]] auto frames() const -> std::uint64_t;
+  [[nodiscard]] auto idle_frames() const -> std::uint64_t;
+
+  // Instructions executed so far, idle loop iterations skipped included
+  [[nodiscard]] auto instructions() const -> std::uint64_t;
+
+  // Changes whenever any pixel does
+  [[nodiscard]] auto screen_hash() const -> std::uint64_t;
+
+  // Changes whenever registers, timers, stack, memory or screen do
+  [[nodiscard]] auto state_hash() const -> std::uint64_t;
+
+  // Frontend API, the null frontend until one is set. The frontend must
+  // outlive this chip8.
+  auto set_display(display& value) -> void;
+  auto set_input(input& value) -> void;
+  auto set_audio(audio& value) -> void;
+
+  auto poll_input() -> void;
+  auto present() -> void;
 
   // Rom file API
   auto load_rom(const std::filesystem::path& file) -> void;
+  auto load_rom(std::span<const byte> rom) -> void;
 
  private:
+  template <quirks Q>
+  auto exec_reference() -> void;
+  auto exec_table() -> void;
+
+  // Runs count instructions on the current engine, returns how many ran
+  auto exec_engine(std::uint64_t count) -> std::uint64_t;
+  auto tick_timers() -> void;
+
+  // Scheduled key changes that are due, and instructions until the next one
+  auto apply_events() -> void;
+  [[nodiscard]] auto until_event() const -> std::uint64_t;
+
+  // Engines running several instructions count down what's left of count
+  template <quirks Q>
+  auto exec_threaded(std::uint64_t& count) -> void;
+  auto exec_cached(std::uint64_t& count) -> void;
+  auto exec_native(std::uint64_t& count) -> void;
+  auto exec_block(const basic_block& block, std::uint64_t& count) -> void;
+
+  // Loop which can't change any state until the next timer tick
+  struct idle_loop {
+    std::uint64_t length;
+    // Register the loop keeps reloading from the delay timer
+    std::optional<regs> reg;
+  };
+
+  [[nodiscard]] auto find_idle_loop() const -> std::optional<idle_loop>;
+
+  // Machine view the shared handlers in semantics.h run on
+  struct view;
+
   auto sys(word addr) -> void;
   auto cls() -> void;
   auto ret() -> void;
@@ -85,20 +233,29 @@ class chip8 {
   auto add(regs reg, byte value) -> void;
   auto add(regs dst, regs src) -> void;
   auto ld(regs dst, regs src) -> void;
+  template <quirks Q>
   auto or_(regs dst, regs src) -> void;
+  template <quirks Q>
   auto and_(regs dst, regs src) -> void;
+  template <quirks Q>
   auto xor_(regs dst, regs src) -> void;
   auto sub(regs dst, regs src) -> void;
+  template <quirks Q>
   auto shr(regs dst, regs src) -> void;
   auto subn(regs dst, regs src) -> void;
+  template <quirks Q>
   auto shl(regs dst, regs src) -> void;
   auto sne(regs reg1, regs reg2) -> void;
   auto ld_i(word addr) -> void;
+  template <quirks Q>
   auto jp_v0(word addr) -> void;
   auto rnd(regs reg, byte value) -> void;
+  template <quirks Q>
   auto drw(regs reg_x, regs reg_y, byte count) -> void;
   auto bcd(regs reg) -> void;
+  template <quirks Q>
   auto st_regs(regs reg) -> void;
+  template <quirks Q>
   auto ld_regs(regs reg) -> void;
   auto skp(regs reg) -> void;
   auto sknp(regs reg) -> void;
@@ -138,35 +295,35 @@ class chip8 {
   [[nodiscard]] auto invalid_opcode(word opcode) const -> std::string;
   auto print_opcode(word addr) const -> void;
 
-  registers m_registers{};
-  word m_i{};
-  byte m_r{};
+  machine_state m_state;
 
-  keyboard m_keyboard;
+  // Sorted by instruction count
+  std::deque<key_event> m_events;
+  // Reused between polls
+  std::vector<key_event> m_polled;
 
-  byte m_dt{};
-  // TOOD - Implement sound timer
-  byte m_st{};
+  std::uint64_t m_ipf{DEFAULT_IPF};
+  std::uint64_t m_idle_frames{};
 
-  timer m_timer{[this]() {
-    this->dt_tick();
-    this->st_tick();
-  }};
+  engine m_engine{engine::reference};
+  profile m_profile{profile::vip};
+  const dispatch_table* m_dispatch{};
+  block_cache m_cache;
+  std::unique_ptr<jit> m_jit;
 
   word m_start_addr{0x0200_w};
-  word m_pc{m_start_addr};
-
-  stack m_stack;
-  memory m_memory{};
 
-  screen m_screen;
+  null_frontend m_null;
+  display* m_display{&m_null};
+  input* m_input{&m_null};
+  audio* m_audio{&m_null};
+  bool m_show{true};
 
-  bool m_raylib{};
-  bool m_is_invalid_state{};
-  bool m_should_close{};
+  // Replaces the xoshiro256** in m_state when set
+  std::unique_ptr<random_source> m_random;
 
-  std::random_device random_device;
-  std::uniform_int_distribution<byte> randomness;
+  // State after every frame, when enabled
+  std::unique_ptr<rewind_buffer> m_rewind;
 };
 }  // namespace chip8
 
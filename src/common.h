@@ -1,22 +1,17 @@
 #ifndef HK_CHIP8_COMMON_H
 #define HK_CHIP8_COMMON_H
 
-#include <raylib.h>
-
 #include <array>
 #include <cstdint>
-#include <map>
 
 #include "helpers.h"
 
-#define BG_COLOR PINK
-#define FG_COLOR MAROON
-
 namespace chip8 {
 constexpr auto WIDTH = 64Z;
 constexpr auto HEIGHT = 32Z;
 
-constexpr auto PIXEL = 10;
+// Instructions executed per 60 Hz frame, roughly a 660 Hz CPU
+constexpr auto DEFAULT_IPF = std::uint64_t{11};
 
 using byte = std::uint8_t;
 using word = std::uint16_t;
@@ -71,38 +66,9 @@ enum class keys : byte {
   KEY_F = 0x0f,
 };
 
-inline const std::map<int, keys> KEYBOARD_MAP{// Row 1
-                                              {KEY_ONE, keys::KEY_1},
-                                              {KEY_TWO, keys::KEY_2},
-                                              {KEY_THREE, keys::KEY_3},
-                                              {KEY_FOUR, keys::KEY_C},
-
-                                              // Row 2
-                                              {KEY_Q, keys::KEY_4},
-                                              {KEY_W, keys::KEY_5},
-                                              {KEY_E, keys::KEY_6},
-                                              {KEY_R, keys::KEY_D},
-
-                                              // Row 3
-                                              {KEY_A, keys::KEY_7},
-                                              {KEY_S, keys::KEY_8},
-                                              {KEY_D, keys::KEY_9},
-                                              {KEY_F, keys::KEY_E},
-
-                                              // Row 4
-                                              {KEY_Z, keys::KEY_A},
-                                              {KEY_X, keys::KEY_0},
-                                              {KEY_C, keys::KEY_B},
-                                              {KEY_V, keys::KEY_F}};
-
 constexpr auto MEMORY_SIZE = 0x1000z;
 using memory = std::array<byte, MEMORY_SIZE>;
 
-struct screen_tag_t {
-  int x;
-};
-constexpr auto with_screen = screen_tag_t{.x = 0};
-
 using font = std::array<byte, 5>;
 using font_table = std::array<font, 16>;
 constexpr auto letters = font_table{
@@ -0,0 +1,32 @@
+#include "differential.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+
+#include "chip8.h"
+
+namespace chip8 {
+auto run_lockstep(chip8& subject, chip8& reference, std::uint64_t count,
+                  std::uint64_t step) -> std::optional<divergence> {
+  auto executed = std::uint64_t{};
+
+  while (executed < count) {
+    auto chunk = std::min(step, count - executed);
+
+    subject.exec_n(chunk);
+    reference.exec_n(chunk);
+    executed += chunk;
+
+    if (auto reason = subject.compare(reference)) {
+      return divergence{.executed = executed, .reason = *reason};
+    }
+
+    if (subject.is_invalid() or reference.is_invalid()) {
+      break;
+    }
+  }
+
+  return std::nullopt;
+}
+}  // namespace chip8
@@ -0,0 +1,22 @@
+#ifndef HK_CHIP8_DIFFERENTIAL_H
+#define HK_CHIP8_DIFFERENTIAL_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "chip8.h"
+
+namespace chip8 {
+struct divergence {
+  std::uint64_t executed;
+  std::string reason;
+};
+
+// Run subject and reference side by side for count instructions, comparing
+// their state every step instructions
+auto run_lockstep(chip8& subject, chip8& reference, std::uint64_t count,
+                  std::uint64_t step = 64) -> std::optional<divergence>;
+}  // namespace chip8
+
+#endif
@@ -0,0 +1,263 @@
+#include "dispatch.h"
+
+#include <cstddef>
+#include <memory>
+
+#include "chip8.h"
+#include "common.h"
+#include "helpers.h"
+#include "parser.h"
+
+namespace chip8 {
+template <quirks Q>
+struct dispatch {
+  using inst = decoded_instruction;
+
+  static auto sys(chip8& cpu, const inst& i) -> void { cpu.sys(i.addr); }
+  static auto cls(chip8& cpu, const inst& /*i*/) -> void { cpu.cls(); }
+  static auto ret(chip8& cpu, const inst& /*i*/) -> void { cpu.ret(); }
+  static auto jp(chip8& cpu, const inst& i) -> void { cpu.jp(i.addr); }
+  static auto call(chip8& cpu, const inst& i) -> void { cpu.call(i.addr); }
+
+  static auto se_byte(chip8& cpu, const inst& i) -> void {
+    cpu.se(i.reg_x, i.lo_byte);
+  }
+
+  static auto sne_byte(chip8& cpu, const inst& i) -> void {
+    cpu.sne(i.reg_x, i.lo_byte);
+  }
+
+  static auto se_regs(chip8& cpu, const inst& i) -> void {
+    cpu.se(i.reg_x, i.reg_y);
+  }
+
+  static auto ld_byte(chip8& cpu, const inst& i) -> void {
+    cpu.ld(i.reg_x, i.lo_byte);
+  }
+
+  static auto add_byte(chip8& cpu, const inst& i) -> void {
+    cpu.add(i.reg_x, i.lo_byte);
+  }
+
+  static auto ld_regs(chip8& cpu, const inst& i) -> void {
+    cpu.ld(i.reg_x, i.reg_y);
+  }
+
+  static auto or_(chip8& cpu, const inst& i) -> void {
+    cpu.template or_<Q>(i.reg_x, i.reg_y);
+  }
+
+  static auto and_(chip8& cpu, const inst& i) -> void {
+    cpu.template and_<Q>(i.reg_x, i.reg_y);
+  }
+
+  static auto xor_(chip8& cpu, const inst& i) -> void {
+    cpu.template xor_<Q>(i.reg_x, i.reg_y);
+  }
+
+  static auto add_regs(chip8& cpu, const inst& i) -> void {
+    cpu.add(i.reg_x, i.reg_y);
+  }
+
+  static auto sub(chip8& cpu, const inst& i) -> void {
+    cpu.sub(i.reg_x, i.reg_y);
+  }
+
+  static auto shr(chip8& cpu, const inst& i) -> void {
+    cpu.template shr<Q>(i.reg_x, i.reg_y);
+  }
+
+  static auto subn(chip8& cpu, const inst& i) -> void {
+    cpu.subn(i.reg_x, i.reg_y);
+  }
+
+  static auto shl(chip8& cpu, const inst& i) -> void {
+    cpu.template shl<Q>(i.reg_x, i.reg_y);
+  }
+
+  static auto sne_regs(chip8& cpu, const inst& i) -> void {
+    cpu.sne(i.reg_x, i.reg_y);
+  }
+
+  static auto ld_i(chip8& cpu, const inst& i) -> void { cpu.ld_i(i.addr); }
+  static auto jp_v0(chip8& cpu, const inst& i) -> void {
+    cpu.template jp_v0<Q>(i.addr);
+  }
+
+  static auto rnd(chip8& cpu, const inst& i) -> void {
+    cpu.rnd(i.reg_x, i.lo_byte);
+  }
+
+  static auto drw(chip8& cpu, const inst& i) -> void {
+    cpu.template drw<Q>(i.reg_x, i.reg_y, i.nibble);
+  }
+
+  static auto skp(chip8& cpu, const inst& i) -> void { cpu.skp(i.reg_x); }
+  static auto sknp(chip8& cpu, const inst& i) -> void { cpu.sknp(i.reg_x); }
+  static auto ld_dt(chip8& cpu, const inst& i) -> void { cpu.ld_dt(i.reg_x); }
+  static auto ld_key(chip8& cpu, const inst& i) -> void { cpu.ld_key(i.reg_x); }
+  static auto st_dt(chip8& cpu, const inst& i) -> void { cpu.st_dt(i.reg_x); }
+  static auto ld_st(chip8& cpu, const inst& i) -> void { cpu.ld_st(i.reg_x); }
+  static auto add_i(chip8& cpu, const inst& i) -> void { cpu.add_i(i.reg_x); }
+
+  static auto ld_font(chip8& cpu, const inst& i) -> void {
+    cpu.ld_font(i.reg_x);
+  }
+
+  static auto bcd(chip8& cpu, const inst& i) -> void { cpu.bcd(i.reg_x); }
+
+  static auto st_regs(chip8& cpu, const inst& i) -> void {
+    cpu.template st_regs<Q>(i.reg_x);
+  }
+
+  static auto ld_regs_i(chip8& cpu, const inst& i) -> void {
+    cpu.template ld_regs<Q>(i.reg_x);
+  }
+
+  static auto invalid(chip8& cpu, const inst& i) -> void {
+    cpu.invalid(i.opcode);
+  }
+};
+
+namespace {
+auto with(decoded_instruction inst, operation op,
+          decoded_instruction::handler handler) -> decoded_instruction {
+  inst.op = op;
+  inst.exec = handler;
+  return inst;
+}
+
+template <quirks Q>
+auto decode_with(word opcode) -> decoded_instruction {
+  using handlers = dispatch<Q>;
+
+  auto parsed = parsed_instruction{opcode};
+
+  auto inst = decoded_instruction{
+      .exec = &handlers::invalid,
+      .op = operation::INVALID,
+      .reg_x = as<regs>(parsed.get_nibble(2)),
+      .reg_y = as<regs>(parsed.get_nibble(1)),
+      .nibble = parsed.get_nibble(0),
+      .lo_byte = parsed.get_lo_byte(),
+      .addr = parsed.get_addr(),
+      .opcode = opcode,
+  };
+
+  switch (parsed.get_nibble(3)) {
+    case 0x0:
+      switch (opcode) {
+        case 0x00e0:
+          return with(inst, operation::CLS, &handlers::cls);
+        case 0x00ee:
+          return with(inst, operation::RET, &handlers::ret);
+        default:
+          return with(inst, operation::SYS, &handlers::sys);
+      }
+    case 0x1:
+      return with(inst, operation::JP, &handlers::jp);
+    case 0x2:
+      return with(inst, operation::CALL, &handlers::call);
+    case 0x3:
+      return with(inst, operation::SE_BYTE, &handlers::se_byte);
+    case 0x4:
+      return with(inst, operation::SNE_BYTE, &handlers::sne_byte);
+    case 0x5:
+      return with(inst, operation::SE_REGS, &handlers::se_regs);
+    case 0x6:
+      return with(inst, operation::LD_BYTE, &handlers::ld_byte);
+    case 0x7:
+      return with(inst, operation::ADD_BYTE, &handlers::add_byte);
+    case 0x8:
+      switch (parsed.get_nibble(0)) {
+        case 0x0:
+          return with(inst, operation::LD_REGS, &handlers::ld_regs);
+        case 0x1:
+          return with(inst, operation::OR, &handlers::or_);
+        case 0x2:
+          return with(inst, operation::AND, &handlers::and_);
+        case 0x3:
+          return with(inst, operation::XOR, &handlers::xor_);
+        case 0x4:
+          return with(inst, operation::ADD_REGS, &handlers::add_regs);
+        case 0x5:
+          return with(inst, operation::SUB, &handlers::sub);
+        case 0x6:
+          return with(inst, operation::SHR, &handlers::shr);
+        case 0x7:
+          return with(inst, operation::SUBN, &handlers::subn);
+        case 0xe:
+          return with(inst, operation::SHL, &handlers::shl);
+        default:
+          return inst;
+      }
+    case 0x9:
+      return with(inst, operation::SNE_REGS, &handlers::sne_regs);
+    case 0xa:
+      return with(inst, operation::LD_I, &handlers::ld_i);
+    case 0xb:
+      return with(inst, operation::JP_V0, &handlers::jp_v0);
+    case 0xc:
+      return with(inst, operation::RND, &handlers::rnd);
+    case 0xd:
+      return with(inst, operation::DRW, &handlers::drw);
+    case 0xe:
+      switch (parsed.get_lo_byte()) {
+        case 0x9e:
+          return with(inst, operation::SKP, &handlers::skp);
+        case 0xa1:
+          return with(inst, operation::SKNP, &handlers::sknp);
+        default:
+          return inst;
+      }
+    case 0xf:
+      switch (parsed.get_lo_byte()) {
+        case 0x07:
+          return with(inst, operation::LD_VX_DT, &handlers::ld_dt);
+        case 0x0a:
+          return with(inst, operation::LD_KEY, &handlers::ld_key);
+        case 0x15:
+          return with(inst, operation::LD_DT, &handlers::st_dt);
+        case 0x18:
+          return with(inst, operation::LD_ST, &handlers::ld_st);
+        case 0x1e:
+          return with(inst, operation::ADD_I, &handlers::add_i);
+        case 0x29:
+          return with(inst, operation::LD_F, &handlers::ld_font);
+        case 0x33:
+          return with(inst, operation::LD_B, &handlers::bcd);
+        case 0x55:
+          return with(inst, operation::LD_I_VX, &handlers::st_regs);
+        case 0x65:
+          return with(inst, operation::LD_VX_I, &handlers::ld_regs_i);
+        default:
+          return inst;
+      }
+    default:
+      return inst;
+  }
+}
+
+}  // namespace
+
+auto decode(word opcode, profile value) -> decoded_instruction {
+  return with_quirks(value,
+                     [opcode]<quirks Q>() { return decode_with<Q>(opcode); });
+}
+
+auto get_dispatch_table(profile value) -> const dispatch_table& {
+  return with_quirks(value, []<quirks Q>() -> const dispatch_table& {
+    static const auto table = [] {
+      auto result = std::make_unique<dispatch_table>();
+
+      for (auto opcode = 0UZ; opcode < result->size(); opcode++) {
+        result->at(opcode) = decode_with<Q>(as<word>(opcode));
+      }
+
+      return result;
+    }();
+
+    return *table;
+  });
+}
+}  // namespace chip8
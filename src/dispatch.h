@@ -0,0 +1,76 @@
+#ifndef HK_CHIP8_DISPATCH_H
+#define HK_CHIP8_DISPATCH_H
+
+#include <array>
+
+#include "common.h"
+#include "quirks.h"
+
+namespace chip8 {
+class chip8;
+
+enum class operation : byte {
+  SYS,
+  CLS,
+  RET,
+  JP,
+  CALL,
+  SE_BYTE,
+  SNE_BYTE,
+  SE_REGS,
+  LD_BYTE,
+  ADD_BYTE,
+  LD_REGS,
+  OR,
+  AND,
+  XOR,
+  ADD_REGS,
+  SUB,
+  SHR,
+  SUBN,
+  SHL,
+  SNE_REGS,
+  LD_I,
+  JP_V0,
+  RND,
+  DRW,
+  SKP,
+  SKNP,
+  LD_VX_DT,
+  LD_KEY,
+  LD_DT,
+  LD_ST,
+  ADD_I,
+  LD_F,
+  LD_B,
+  LD_I_VX,
+  LD_VX_I,
+  INVALID,
+};
+
+// An opcode with its handler and operands extracted ahead of time
+struct decoded_instruction {
+  using handler = auto (*)(chip8& cpu, const decoded_instruction& inst)
+      -> void;
+
+  handler exec{};
+  operation op{operation::INVALID};
+  regs reg_x{};
+  regs reg_y{};
+  byte nibble{};
+  byte lo_byte{};
+  word addr{};
+  word opcode{};
+};
+
+using dispatch_table = std::array<decoded_instruction, 0x10000>;
+
+[[nodiscard]] auto decode(word opcode, profile value = profile::vip)
+    -> decoded_instruction;
+
+// Every opcode decoded once per profile, built on first use
+[[nodiscard]] auto get_dispatch_table(profile value = profile::vip)
+    -> const dispatch_table&;
+}  // namespace chip8
+
+#endif
@@ -0,0 +1,168 @@
+#include "fleet.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "chip8.h"
+#include "common.h"
+#include "rom.h"
+
+namespace chip8 {
+namespace {
+// Jobs owned by one worker, taken from the back by the owner and from the
+// front by thieves
+class work_queue {
+ public:
+  auto push(std::size_t job) -> void {
+    auto lock = std::scoped_lock{m_lock};
+    m_jobs.push_back(job);
+  }
+
+  auto pop() -> std::optional<std::size_t> {
+    auto lock = std::scoped_lock{m_lock};
+
+    if (m_jobs.empty()) {
+      return std::nullopt;
+    }
+
+    auto job = m_jobs.back();
+    m_jobs.pop_back();
+    return job;
+  }
+
+  auto steal() -> std::optional<std::size_t> {
+    auto lock = std::scoped_lock{m_lock};
+
+    if (m_jobs.empty()) {
+      return std::nullopt;
+    }
+
+    auto job = m_jobs.front();
+    m_jobs.pop_front();
+    return job;
+  }
+
+ private:
+  std::mutex m_lock;
+  std::deque<std::size_t> m_jobs;
+};
+}  // namespace
+
+fleet::fleet(fleet_config config) : m_config(config) {}
+
+auto fleet::add(std::span<const byte> rom, std::size_t count) -> std::size_t {
+  auto index = m_roms.size();
+
+  m_roms.emplace_back(rom.begin(), rom.end());
+  m_instances.insert(m_instances.end(), count, index);
+
+  return index;
+}
+
+auto fleet::add(const std::filesystem::path& rom, std::size_t count)
+    -> std::optional<std::size_t> {
+  auto data = read_rom(rom);
+
+  if (not data) {
+    return std::nullopt;
+  }
+
+  return add(*data, count);
+}
+
+auto fleet::size() const -> std::size_t { return m_instances.size(); }
+
+auto fleet::run() const -> std::vector<fleet_result> {
+  auto results = std::vector<fleet_result>(m_instances.size());
+
+  auto threads = m_config.threads;
+  if (threads == 0) {
+    threads = std::max(std::thread::hardware_concurrency(), 1U);
+  }
+  threads = std::clamp<std::size_t>(threads, 1, std::max(size(), 1UZ));
+
+  auto queues = std::vector<std::unique_ptr<work_queue>>{};
+  for (auto idx = 0UZ; idx < threads; idx++) {
+    queues.push_back(std::make_unique<work_queue>());
+  }
+
+  for (auto job = 0UZ; job < m_instances.size(); job++) {
+    queues.at(job % threads)->push(job);
+  }
+
+  auto worker = [&](std::size_t self) {
+    while (true) {
+      auto job = queues.at(self)->pop();
+
+      // Out of work, take the oldest job of the next busy worker
+      for (auto idx = 1UZ; not job and idx < threads; idx++) {
+        job = queues.at((self + idx) % threads)->steal();
+      }
+
+      // Nothing is queued once the pool starts, so empty queues stay empty
+      if (not job) {
+        return;
+      }
+
+      results.at(*job) = run_one(*job);
+    }
+  };
+
+  {
+    auto pool = std::vector<std::jthread>{};
+    for (auto idx = 0UZ; idx < threads; idx++) {
+      pool.emplace_back(worker, idx);
+    }
+  }
+
+  return results;
+}
+
+auto fleet::run_one(std::size_t instance) const -> fleet_result {
+  auto rom = m_instances.at(instance);
+  auto emulator = std::make_unique<chip8>();
+
+  if (m_config.seed) {
+    emulator->seed(*m_config.seed + instance);
+  }
+
+  emulator->set_profile(m_config.cpu_profile);
+  emulator->set_engine(m_config.cpu_engine);
+  emulator->set_timer_period(m_config.timer_period);
+  emulator->load_rom(m_roms.at(rom));
+
+  if (m_config.instructions != 0) {
+    // No frames go by here, so the timers tick every frame's worth instead
+    if (m_config.timer_period == 0) {
+      emulator->set_timer_period(emulator->ipf());
+    }
+
+    emulator->exec_n(m_config.instructions);
+  } else {
+    for (auto frame = 0UZ; frame < m_config.frames; frame++) {
+      if (emulator->is_invalid() or emulator->waiting_for_key()) {
+        break;
+      }
+
+      emulator->exec_frame();
+    }
+  }
+
+  return fleet_result{
+      .rom = rom,
+      .instructions = emulator->instructions(),
+      .screen_hash = emulator->screen_hash(),
+      .invalid = emulator->is_invalid(),
+      .waiting = emulator->waiting_for_key(),
+  };
+}
+}  // namespace chip8
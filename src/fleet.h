@@ -0,0 +1,73 @@
+#ifndef HK_CHIP8_FLEET_H
+#define HK_CHIP8_FLEET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "chip8.h"
+#include "common.h"
+#include "quirks.h"
+
+namespace chip8 {
+struct fleet_config {
+  engine cpu_engine{engine::reference};
+  profile cpu_profile{profile::vip};
+
+  // Frames to run every instance for, as fast as the host allows
+  std::uint64_t frames{600};
+  // Instructions to run instead of frames, when not zero
+  std::uint64_t instructions{};
+
+  // Instructions per DT/ST tick, once per frame (or per IPF instructions
+  // when running by instructions) when zero
+  std::uint64_t timer_period{};
+
+  // Worker threads, one per core when zero
+  std::size_t threads{};
+
+  // RND seed of the first instance, the one queued n-th gets seed + n
+  std::optional<std::uint64_t> seed{};
+};
+
+struct fleet_result {
+  // Index returned by fleet::add() for the ROM
+  std::size_t rom;
+
+  std::uint64_t instructions;
+  std::uint64_t screen_hash;
+  bool invalid;
+  // Parked on LD Vx, K, nothing in a fleet can press a key so the instance
+  // stopped there
+  bool waiting;
+};
+
+// Many headless instances run to the same budget on a work-stealing pool
+class fleet {
+ public:
+  explicit fleet(fleet_config config);
+
+  // Queue count instances of rom, returns the index results refer to it by.
+  // Nothing is queued for a file that can't be read.
+  auto add(std::span<const byte> rom, std::size_t count = 1) -> std::size_t;
+  auto add(const std::filesystem::path& rom, std::size_t count = 1)
+      -> std::optional<std::size_t>;
+
+  [[nodiscard]] auto size() const -> std::size_t;
+
+  // Run every queued instance, results are in the order they were queued
+  [[nodiscard]] auto run() const -> std::vector<fleet_result>;
+
+ private:
+  auto run_one(std::size_t instance) const -> fleet_result;
+
+  fleet_config m_config;
+  std::vector<std::vector<byte>> m_roms;
+  std::vector<std::size_t> m_instances;
+};
+}  // namespace chip8
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef HK_CHIP8_FRONTEND_H
+#define HK_CHIP8_FRONTEND_H
+
+#include <vector>
+
+#include "keyboard.h"
+#include "screen.h"
+
+namespace chip8 {
+// Host side of the machine. chip8 only talks to these, so the core builds
+// without any windowing, input or audio library.
+class display {
+ public:
+  virtual ~display() = default;
+
+  // Called once per frame with the finished screen. Its dirty rows are the
+  // ones changed since the previous call, nothing else needs redrawing.
+  virtual auto present(const screen& value) -> void = 0;
+
+  // The user asked to quit
+  [[nodiscard]] virtual auto closed() -> bool = 0;
+};
+
+class input {
+ public:
+  virtual ~input() = default;
+
+  // Called once per frame before any instruction runs. Appends the key
+  // changes since the previous call in the order they happened, the core
+  // stamps them so at is ignored.
+  virtual auto poll(std::vector<key_event>& events) -> void = 0;
+
+  // Held to step back through the rewind buffer, a frame at a time instead
+  // of running one
+  [[nodiscard]] virtual auto rewinding() -> bool { return false; }
+};
+
+class audio {
+ public:
+  virtual ~audio() = default;
+
+  // Called once per frame, on while the sound timer is running. Runs on the
+  // emulation thread, so it should only flip a flag.
+  virtual auto tone(bool on) -> void = 0;
+};
+
+// Headless backend for tests, benchmarks and fleet runs. Input only changes
+// through chip8::press(), chip8::release() and chip8::schedule().
+class null_frontend final : public display, public input, public audio {
+ public:
+  auto present(const screen& /* value */) -> void override {}
+  [[nodiscard]] auto closed() -> bool override { return false; }
+
+  auto poll(std::vector<key_event>& /* events */) -> void override {}
+
+  auto tone(bool /* on */) -> void override {}
+};
+}  // namespace chip8
+
+#endif
@@ -0,0 +1,310 @@
+#include "jit.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+
+#define HK_CHIP8_JIT 1
+#endif
+
+#include "block_cache.h"
+#include "common.h"
+#include "dispatch.h"
+#include "helpers.h"
+
+namespace chip8 {
+namespace {
+// [r12 + VF], where the pinned V0-VF pointer lives
+constexpr auto FLAG = as<byte>(regs::VF);
+
+auto index(regs reg) -> byte { return as<byte>(reg); }
+}  // namespace
+
+auto jit::supported() -> bool {
+#if defined(HK_CHIP8_JIT)
+  return true;
+#else
+  return false;
+#endif
+}
+
+jit::jit(quirks value) : m_quirks(value) {
+#if defined(HK_CHIP8_JIT)
+  auto* buffer = mmap(nullptr, BUFFER_SIZE, PROT_READ | PROT_EXEC,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (buffer != MAP_FAILED) {
+    m_buffer = static_cast<byte*>(buffer);
+  }
+#endif
+}
+
+jit::~jit() {
+#if defined(HK_CHIP8_JIT)
+  if (m_buffer != nullptr) {
+    munmap(m_buffer, BUFFER_SIZE);
+  }
+#endif
+}
+
+auto jit::available() const -> bool {
+  return m_buffer != nullptr and not m_failed;
+}
+
+auto jit::reset() -> void { m_used = 0; }
+
+auto jit::emit(std::initializer_list<byte> code) -> void {
+  m_code.insert(m_code.end(), code);
+}
+
+auto jit::emit8(byte value) -> void { m_code.push_back(value); }
+
+auto jit::emit16(word value) -> void {
+  emit8(as<byte>(value));
+  emit8(as<byte>(value >> 8));
+}
+
+auto jit::emit32(std::uint32_t value) -> void {
+  emit16(as<word>(value));
+  emit16(as<word>(value >> 16));
+}
+
+auto jit::emit64(std::uint64_t value) -> void {
+  emit32(as<std::uint32_t>(value));
+  emit32(as<std::uint32_t>(value >> 32));
+}
+
+auto jit::emit_set_pc(word pc) -> void {
+  // mov word [r14], pc
+  emit({0x66, 0x41, 0xc7, 0x06});
+  emit16(pc);
+}
+
+auto jit::emit_native(const decoded_instruction& inst) -> bool {
+  auto reg_x = index(inst.reg_x);
+  auto reg_y = index(inst.reg_y);
+
+  // mov al, [r12 + reg]
+  auto load_al = [this](byte reg) { emit({0x41, 0x8a, 0x44, 0x24, reg}); };
+
+  // mov [r12 + reg], al
+  auto store_al = [this](byte reg) { emit({0x41, 0x88, 0x44, 0x24, reg}); };
+
+  // mov [r12 + VF], cl
+  auto store_flag = [this] { emit({0x41, 0x88, 0x4c, 0x24, FLAG}); };
+
+  // mov byte [r12 + VF], 0
+  auto reset_flag = [this] {
+    if (m_quirks.vf_reset) {
+      emit({0x41, 0xc6, 0x44, 0x24, FLAG, 0x00});
+    }
+  };
+
+  // Shifts read VY or shift VX in place
+  auto shift_src = m_quirks.shift_vy ? reg_y : reg_x;
+
+  switch (inst.op) {
+    case operation::LD_BYTE:
+      // mov byte [r12 + x], nn
+      emit({0x41, 0xc6, 0x44, 0x24, reg_x, inst.lo_byte});
+      return true;
+    case operation::ADD_BYTE:
+      // add byte [r12 + x], nn
+      emit({0x41, 0x80, 0x44, 0x24, reg_x, inst.lo_byte});
+      return true;
+    case operation::LD_REGS:
+      load_al(reg_y);
+      store_al(reg_x);
+      return true;
+    case operation::OR:
+      // or [r12 + x], al
+      load_al(reg_y);
+      emit({0x41, 0x08, 0x44, 0x24, reg_x});
+      reset_flag();
+      return true;
+    case operation::AND:
+      // and [r12 + x], al
+      load_al(reg_y);
+      emit({0x41, 0x20, 0x44, 0x24, reg_x});
+      reset_flag();
+      return true;
+    case operation::XOR:
+      // xor [r12 + x], al
+      load_al(reg_y);
+      emit({0x41, 0x30, 0x44, 0x24, reg_x});
+      reset_flag();
+      return true;
+    case operation::ADD_REGS:
+      // add al, [r12 + y]; setc cl
+      load_al(reg_x);
+      emit({0x41, 0x02, 0x44, 0x24, reg_y});
+      emit({0x0f, 0x92, 0xc1});
+      store_al(reg_x);
+      store_flag();
+      return true;
+    case operation::SUB:
+      // sub al, [r12 + y]; setnc cl
+      load_al(reg_x);
+      emit({0x41, 0x2a, 0x44, 0x24, reg_y});
+      emit({0x0f, 0x93, 0xc1});
+      store_al(reg_x);
+      store_flag();
+      return true;
+    case operation::SUBN:
+      // sub al, [r12 + x]; setnc cl
+      load_al(reg_y);
+      emit({0x41, 0x2a, 0x44, 0x24, reg_x});
+      emit({0x0f, 0x93, 0xc1});
+      store_al(reg_x);
+      store_flag();
+      return true;
+    case operation::SHR:
+      // shr al, 1; setc cl
+      load_al(shift_src);
+      emit({0xd0, 0xe8, 0x0f, 0x92, 0xc1});
+      store_al(reg_x);
+      store_flag();
+      return true;
+    case operation::SHL:
+      // shl al, 1; setc cl
+      load_al(shift_src);
+      emit({0xd0, 0xe0, 0x0f, 0x92, 0xc1});
+      store_al(reg_x);
+      store_flag();
+      return true;
+    case operation::LD_I:
+      // mov word [r13 + 0], nnn
+      emit({0x66, 0x41, 0xc7, 0x45, 0x00});
+      emit16(inst.addr);
+      return true;
+    case operation::ADD_I:
+      // movzx eax, byte [r12 + x]; add word [r13 + 0], ax
+      emit({0x41, 0x0f, 0xb6, 0x44, 0x24, reg_x});
+      emit({0x66, 0x41, 0x01, 0x45, 0x00});
+      return true;
+    default:
+      return false;
+  }
+}
+
+auto jit::emit_fallback(const decoded_instruction& inst, word next_pc)
+    -> void {
+  emit_set_pc(next_pc);
+
+  // mov rdi, rbx
+  emit({0x48, 0x89, 0xdf});
+
+  // mov rsi, &inst
+  emit({0x48, 0xbe});
+  emit64(std::bit_cast<std::uint64_t>(&inst));
+
+  // mov rax, handler; call rax
+  emit({0x48, 0xb8});
+  emit64(std::bit_cast<std::uint64_t>(inst.exec));
+  emit({0xff, 0xd0});
+}
+
+auto jit::compile(const basic_block& block, const std::uint64_t* epoch)
+    -> native_block {
+  if (not available()) {
+    return nullptr;
+  }
+
+  m_code.clear();
+
+  // Jumps to the epilogue, patched once its offset is known
+  auto exits = std::vector<std::size_t>{};
+
+  // push rbx; push r12; push r13; push r14; push r15
+  emit({0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57});
+
+  // mov rbx, rdi; mov r12, rsi; mov r13, rdx; mov r14, rcx
+  emit({0x48, 0x89, 0xfb, 0x49, 0x89, 0xf4, 0x49, 0x89, 0xd5, 0x49, 0x89, 0xce});
+
+  // mov rax, epoch; mov r15, [rax]
+  emit({0x48, 0xb8});
+  emit64(std::bit_cast<std::uint64_t>(epoch));
+  emit({0x4c, 0x8b, 0x38});
+
+  auto pc = block.start;
+  auto executed = 0U;
+  auto last_native = false;
+
+  for (const auto& inst : block.ops) {
+    pc = address(pc + 2);
+    executed++;
+
+    last_native = emit_native(inst);
+    if (last_native) {
+      continue;
+    }
+
+    emit_fallback(inst, pc);
+
+    if (executed == block.ops.size()) {
+      break;
+    }
+
+    // Stop if the handler wrote over any cached block, this one included
+    // mov eax, executed; mov rdx, epoch; cmp [rdx], r15; jne epilogue
+    emit8(0xb8);
+    emit32(executed);
+    emit({0x48, 0xba});
+    emit64(std::bit_cast<std::uint64_t>(epoch));
+    emit({0x4c, 0x39, 0x3a, 0x0f, 0x85});
+    exits.push_back(m_code.size());
+    emit32(0);
+  }
+
+  if (last_native) {
+    emit_set_pc(pc);
+  }
+
+  // mov eax, executed
+  emit8(0xb8);
+  emit32(executed);
+
+  auto epilogue = m_code.size();
+  for (auto offset : exits) {
+    auto rel = as<std::uint32_t>(epilogue - (offset + 4));
+    std::memcpy(&m_code.at(offset), &rel, sizeof(rel));
+  }
+
+  // pop r15; pop r14; pop r13; pop r12; pop rbx; ret
+  emit({0x41, 0x5f, 0x41, 0x5e, 0x41, 0x5d, 0x41, 0x5c, 0x5b, 0xc3});
+
+  if (m_used + m_code.size() > BUFFER_SIZE) {
+    return nullptr;
+  }
+
+#if defined(HK_CHIP8_JIT)
+  auto* target = std::next(m_buffer, as<std::ptrdiff_t>(m_used));
+
+  if (mprotect(m_buffer, BUFFER_SIZE, PROT_READ | PROT_WRITE) != 0) {
+    m_failed = true;
+    return nullptr;
+  }
+
+  std::ranges::copy(m_code, target);
+
+  if (mprotect(m_buffer, BUFFER_SIZE, PROT_READ | PROT_EXEC) != 0) {
+    m_failed = true;
+    return nullptr;
+  }
+
+  // Keep every block 16 byte aligned
+  m_used += (m_code.size() + 0xf) & ~0xfUZ;
+
+  return std::bit_cast<native_block>(target);
+#else
+  return nullptr;
+#endif
+}
+}  // namespace chip8
@@ -0,0 +1,65 @@
+#ifndef HK_CHIP8_JIT_H
+#define HK_CHIP8_JIT_H
+
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+#include "block_cache.h"
+#include "common.h"
+#include "dispatch.h"
+#include "quirks.h"
+
+namespace chip8 {
+// Compiles hot basic blocks to x86-64. V0-VF and I are accessed through
+// pinned pointers, everything else calls the interpreter handlers.
+class jit {
+ public:
+  static constexpr auto BUFFER_SIZE = 0x100000UZ;
+  static constexpr auto HOT_THRESHOLD = 16U;
+
+  explicit jit(quirks value = profiles::vip);
+  ~jit();
+
+  explicit jit(const jit&) = delete;
+  jit(jit&&) = delete;
+
+  auto operator=(const jit&) -> jit& = delete;
+  auto operator=(jit&&) -> jit& = delete;
+
+  // Whether this host can run generated code at all
+  [[nodiscard]] static auto supported() -> bool;
+
+  // Whether compile() can still produce code, false on hosts without
+  // support or once the buffer couldn't be made writable or executable
+  [[nodiscard]] auto available() const -> bool;
+
+  // Host code for block, nullptr once the buffer is full or unavailable
+  auto compile(const basic_block& block, const std::uint64_t* epoch)
+      -> native_block;
+
+  // Forget all generated code
+  auto reset() -> void;
+
+ private:
+  auto emit(std::initializer_list<byte> code) -> void;
+  auto emit8(byte value) -> void;
+  auto emit16(word value) -> void;
+  auto emit32(std::uint32_t value) -> void;
+  auto emit64(std::uint64_t value) -> void;
+
+  auto emit_native(const decoded_instruction& inst) -> bool;
+  auto emit_fallback(const decoded_instruction& inst, word next_pc) -> void;
+  auto emit_set_pc(word pc) -> void;
+
+  quirks m_quirks;
+
+  std::vector<byte> m_code;
+  byte* m_buffer{};
+  std::size_t m_used{};
+  // mprotect() failed, the buffer may be neither writable nor executable
+  bool m_failed{};
+};
+}  // namespace chip8
+
+#endif
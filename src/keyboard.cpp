@@ -1,7 +1,5 @@
 #include "keyboard.h"
 
-#include <raylib.h>
-
 #include <optional>
 
 #include "common.h"
@@ -16,17 +14,9 @@ auto keyboard::is_pressed() const -> bool { return m_keys.any(); }
 
 auto keyboard::press(keys key) -> void { m_keys.set(as<int>(key)); }
 
-auto keyboard::clear() -> void { m_keys.reset(); }
-
-auto keyboard::check() -> void {
-  clear();
+auto keyboard::clear(keys key) -> void { m_keys.reset(as<int>(key)); }
 
-  for (const auto& [key, value] : KEYBOARD_MAP) {
-    if (IsKeyDown(key)) {
-      press(value);
-    }
-  }
-}
+auto keyboard::clear() -> void { m_keys.reset(); }
 
 auto keyboard::key() const -> std::optional<keys> {
   for (auto idx = 0; idx < m_keys.size(); idx++) {
@@ -2,11 +2,21 @@
 #define HK_CHIP8_KEYBOARD_H
 
 #include <bitset>
+#include <cstdint>
 #include <optional>
 
 #include "common.h"
 
 namespace chip8 {
+// A key going down or up, once the instruction count reaches at
+struct key_event {
+  std::uint64_t at;
+  keys key;
+  bool down;
+
+  auto operator==(const key_event& other) const -> bool = default;
+};
+
 class keyboard {
  public:
   [[nodiscard]] auto is_pressed(keys key) const -> bool;
@@ -18,7 +28,7 @@ class keyboard {
 
   [[nodiscard]] auto key() const -> std::optional<keys>;
 
-  auto check() -> void;
+  auto operator==(const keyboard& other) const -> bool = default;
 
  private:
   std::bitset<16> m_keys;
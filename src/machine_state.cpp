@@ -0,0 +1,142 @@
+#include "machine_state.h"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <utility>
+
+#include "common.h"
+#include "helpers.h"
+
+namespace chip8 {
+namespace {
+constexpr auto MAGIC = std::array<char, 4>{'C', '8', 'S', 'T'};
+constexpr auto VERSION = std::uint32_t{2};
+
+struct header {
+  std::array<char, 4> magic;
+  std::uint32_t version;
+  std::uint32_t size;
+  // FNV-1a over the state bytes
+  std::uint64_t checksum;
+};
+
+using state_bytes = std::array<std::byte, sizeof(machine_state)>;
+
+auto checksum(std::span<const std::byte> data) -> std::uint64_t {
+  auto result = 0xcbf29ce484222325ULL;
+
+  for (auto value : data) {
+    result ^= std::to_integer<std::uint64_t>(value);
+    result *= 0x100000001b3ULL;
+  }
+
+  return result;
+}
+
+// Offset of a member, found on a value since machine_state isn't standard
+// layout
+template <typename T>
+auto member_offset(T machine_state::* member) -> std::size_t {
+  auto probe = machine_state{};
+  auto offset = reinterpret_cast<const std::byte*>(&(probe.*member)) -
+                reinterpret_cast<const std::byte*>(&probe);
+
+  return as<std::size_t>(offset);
+}
+
+// Offset of the engaged flag in an optional key, the first byte holding 1
+// whichever key it waits for
+auto engaged_offset() -> std::size_t {
+  using optional_bytes = std::array<std::byte, sizeof(std::optional<keys>)>;
+  auto low = std::bit_cast<optional_bytes>(std::optional{keys::KEY_0});
+  auto high = std::bit_cast<optional_bytes>(std::optional{keys::KEY_F});
+
+  for (auto idx = 0UZ; idx < low.size(); idx++) {
+    if (low.at(idx) == std::byte{1} and high.at(idx) == std::byte{1}) {
+      return idx;
+    }
+  }
+
+  return 0;
+}
+
+// Fields any instruction stream leaves within range, so a state outside them
+// could never have been written
+auto is_valid(const machine_state& state) -> bool {
+  if (state.stack.size() > state.stack.capacity()) {
+    return false;
+  }
+
+  // Running off the end of memory stops on the zero read past it
+  if (state.pc > MEMORY_SIZE) {
+    return false;
+  }
+
+  if (not state.timer.per_frame() and
+      state.timer.until_tick() > state.timer.period()) {
+    return false;
+  }
+
+  return not state.key_wait or
+         std::to_underlying(*state.key_wait) <= std::to_underlying(keys::KEY_F);
+}
+}  // namespace
+
+auto write_state(std::ostream& out, const machine_state& state) -> void {
+  auto data = std::bit_cast<state_bytes>(state);
+  auto info = header{
+      .magic = MAGIC,
+      .version = VERSION,
+      .size = sizeof(machine_state),
+      .checksum = checksum(data),
+  };
+
+  out.write(reinterpret_cast<const char*>(&info), sizeof(info));
+  out.write(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+auto read_state(std::istream& in) -> std::optional<machine_state> {
+  auto info = header{};
+  in.read(reinterpret_cast<char*>(&info), sizeof(info));
+
+  if (not in or info.magic != MAGIC or info.version != VERSION or
+      info.size != sizeof(machine_state)) {
+    return std::nullopt;
+  }
+
+  auto data = state_bytes{};
+  in.read(reinterpret_cast<char*>(data.data()), data.size());
+
+  if (not in or checksum(data) != info.checksum) {
+    return std::nullopt;
+  }
+
+  // Anything but 0 or 1 in a bool is undefined once it's read as one, the
+  // flag inside key_wait included
+  const auto flags = {
+      member_offset(&machine_state::invalid),
+      member_offset(&machine_state::key_parked),
+      member_offset(&machine_state::key_wait) + engaged_offset(),
+  };
+
+  for (auto offset : flags) {
+    if (data.at(offset) > std::byte{1}) {
+      return std::nullopt;
+    }
+  }
+
+  auto state = std::bit_cast<machine_state>(data);
+
+  if (not is_valid(state)) {
+    return std::nullopt;
+  }
+
+  return state;
+}
+}  // namespace chip8
@@ -0,0 +1,60 @@
+#ifndef HK_CHIP8_MACHINE_STATE_H
+#define HK_CHIP8_MACHINE_STATE_H
+
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <type_traits>
+
+#include "common.h"
+#include "keyboard.h"
+#include "screen.h"
+#include "stack.h"
+#include "timer.h"
+
+namespace chip8 {
+// Everything a running program can observe, as plain data. Copying it is a
+// memcpy, so a snapshot every frame is cheap enough for rewind, fork and
+// run-ahead. Settings such as the engine, profile and frontends stay in
+// chip8.
+struct machine_state {
+  ::chip8::registers registers{};
+  word i{};
+  word pc{0x0200_w};
+  ::chip8::stack stack{};
+  ::chip8::memory memory{};
+  ::chip8::screen screen{};
+
+  byte dt{};
+  byte st{};
+  // Clock behind DT and ST when they tick every few instructions
+  ::chip8::timer timer{};
+
+  // xoshiro256** state behind RND, and its last result
+  std::array<std::uint64_t, 4> rng{};
+  byte r{};
+
+  ::chip8::keyboard keyboard{};
+  // Key LD Vx, K saw go down, waiting for it to come up
+  std::optional<keys> key_wait;
+  bool key_parked{};
+
+  bool invalid{};
+
+  std::uint64_t instructions{};
+  std::uint64_t frames{};
+};
+
+static_assert(std::is_trivially_copyable_v<machine_state>);
+
+// Binary save states: a magic, the format version, the size of the state, a
+// checksum and the state as it is laid out in memory. Only loads on the build
+// and host which wrote it, and only a state a program could have reached.
+auto write_state(std::ostream& out, const machine_state& state) -> void;
+[[nodiscard]] auto read_state(std::istream& in)
+    -> std::optional<machine_state>;
+}  // namespace chip8
+
+#endif
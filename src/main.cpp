@@ -1,10 +1,29 @@
 #include <fmt/base.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <cxxopts.hpp>
 #include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <magic_enum/magic_enum.hpp>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
 
 #include "chip8.h"
 #include "common.h"
+#include "differential.h"
+#include "fleet.h"
+#include "helpers.h"
+#include "movie.h"
+#include "quirks.h"
+#include "raylib_frontend.h"
+#include "terminal_frontend.h"
+#include "video.h"
 
 auto main(int argc, char* argv[]) -> int {
   auto args = cxxopts::Options("chip8");
@@ -15,22 +34,383 @@ auto main(int argc, char* argv[]) -> int {
     ("d,debug", "Enable debugging")
     ("h,help", "Display help")
     ("r,rom", "Load ROM file", cxxopts::value<std::filesystem::path>())
+    ("i,ipf", "Instructions per frame", cxxopts::value<std::uint64_t>())
+    ("e,engine", "Interpreter engine", cxxopts::value<std::string>())
+    ("p,profile", "Quirks profile: vip, schip or xochip",
+      cxxopts::value<std::string>())
+    ("u,unthrottled", "Run frames as fast as possible")
+    ("terminal", "Draw on the terminal instead of opening a window")
+    ("keymap", "Host keys for CHIP-8 keys 0 to F, default x123qweasdzc4rfv",
+      cxxopts::value<std::string>())
+    ("timer-period", "Tick DT and ST every N instructions instead of every "
+      "frame", cxxopts::value<std::uint64_t>())
+    ("s,seed", "Seed RND for a reproducible run",
+      cxxopts::value<std::uint64_t>())
+    ("differential", "Check N instructions against the reference engine",
+      cxxopts::value<std::uint64_t>())
+    ("fleet", "Run N headless instances of the ROM, or of every ROM in a "
+      "directory", cxxopts::value<std::size_t>())
+    ("frames", "Frames each fleet instance or recording runs for",
+      cxxopts::value<std::uint64_t>())
+    ("instructions", "Instructions each fleet instance runs for",
+      cxxopts::value<std::uint64_t>())
+    ("threads", "Fleet worker threads", cxxopts::value<std::size_t>())
+    ("record", "Write the session's input to a movie file",
+      cxxopts::value<std::filesystem::path>())
+    ("replay", "Run a movie headless at full speed and check its final state",
+      cxxopts::value<std::filesystem::path>())
+    ("record-video", "Run headless and write every frame to a file, or - "
+      "for stdout", cxxopts::value<std::string>())
+    ("video-format", "Recording format: raw, pbm or y4m",
+      cxxopts::value<std::string>())
+    ("rewind", "Keep the last N seconds to step back through while "
+      "Backspace is held", cxxopts::value<std::size_t>())
   ;
   // clang-format on
 
   auto options = args.parse(argc, argv);
 
-  fmt::println("chip8 emulator by hellokartikey!");
+  // Recordings may go to stdout, keep it clean for them
+  auto* banner = options.count("record-video") != 0 and
+                         options["record-video"].as<std::string>() == "-"
+                     ? stderr
+                     : stdout;
+
+  fmt::println(banner, "chip8 emulator by hellokartikey!");
 
   if (options.count("help") != 0) {
     fmt::println(stderr, "{}", args.help());
     return 1;
   }
 
-  auto interpreter = chip8::chip8{chip8::with_screen};
+  auto engine = chip8::engine::reference;
+
+  if (options.count("engine") != 0) {
+    auto name = options["engine"].as<std::string>();
+    auto value = magic_enum::enum_cast<chip8::engine>(name);
+
+    if (not value) {
+      fmt::println(stderr, "Invalid engine {}", name);
+      return 1;
+    }
+
+    engine = *value;
+  }
+
+  auto profile = chip8::profile::vip;
+
+  if (options.count("profile") != 0) {
+    auto name = options["profile"].as<std::string>();
+    auto value = magic_enum::enum_cast<chip8::profile>(name);
+
+    if (not value) {
+      fmt::println(stderr, "Invalid profile {}", name);
+      return 1;
+    }
+
+    profile = *value;
+  }
+
+  auto timer_period = std::uint64_t{};
+
+  if (options.count("timer-period") != 0) {
+    timer_period = options["timer-period"].as<std::uint64_t>();
+  }
+
+  auto seed = std::optional<std::uint64_t>{};
+
+  if (options.count("seed") != 0) {
+    seed = options["seed"].as<std::uint64_t>();
+  }
+
+  if (options.count("differential") != 0) {
+    auto subject = chip8::chip8{};
+    auto reference = chip8::chip8{};
+
+    // Both sides have to draw the same RND bytes, seeded or not
+    auto value = seed.value_or(std::random_device{}());
+    subject.seed(value);
+    reference.seed(value);
+
+    subject.set_profile(profile);
+    reference.set_profile(profile);
+    subject.set_timer_period(timer_period);
+    reference.set_timer_period(timer_period);
+    subject.set_engine(engine);
+
+    if (options.count("rom") != 0) {
+      subject.load_rom(options["rom"].as<std::filesystem::path>());
+      reference.load_rom(options["rom"].as<std::filesystem::path>());
+    }
+
+    auto count = options["differential"].as<std::uint64_t>();
+
+    if (auto diff = chip8::run_lockstep(subject, reference, count)) {
+      fmt::println(stderr, "Diverged within {} instructions: {}",
+                   diff->executed, diff->reason);
+      return 1;
+    }
+
+    fmt::println("No divergence in {} instructions", count);
+    return 0;
+  }
+
+  if (options.count("fleet") != 0) {
+    if (options.count("rom") == 0) {
+      fmt::println(stderr, "--fleet needs a ROM file or directory");
+      return 1;
+    }
+
+    auto config = chip8::fleet_config{
+        .cpu_engine = engine,
+        .cpu_profile = profile,
+        .timer_period = timer_period,
+        .seed = seed,
+    };
+
+    if (options.count("frames") != 0) {
+      config.frames = options["frames"].as<std::uint64_t>();
+    }
+
+    if (options.count("instructions") != 0) {
+      config.instructions = options["instructions"].as<std::uint64_t>();
+    }
+
+    if (options.count("threads") != 0) {
+      config.threads = options["threads"].as<std::size_t>();
+    }
+
+    auto path = options["rom"].as<std::filesystem::path>();
+    auto roms = std::vector<std::filesystem::path>{};
+
+    if (std::filesystem::is_directory(path)) {
+      for (const auto& entry : std::filesystem::directory_iterator{path}) {
+        if (entry.is_regular_file()) {
+          roms.push_back(entry.path());
+        }
+      }
+
+      std::ranges::sort(roms);
+    } else {
+      roms.push_back(path);
+    }
+
+    auto runner = chip8::fleet{config};
+    for (const auto& rom : roms) {
+      if (not runner.add(rom, options["fleet"].as<std::size_t>())) {
+        fmt::println(stderr, "Invalid rom file {}", rom.string());
+        return 1;
+      }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto results = runner.run();
+    auto elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start);
+
+    auto total = std::uint64_t{};
+    for (const auto& result : results) {
+      fmt::println("{} {:016x} {} {}", roms.at(result.rom).string(),
+                   result.screen_hash, result.instructions,
+                   result.invalid   ? "invalid"
+                   : result.waiting ? "waiting"
+                                    : "ok");
+      total += result.instructions;
+    }
+
+    fmt::println("{} instances in {:.3f}s, {:.1f} MIPS", results.size(),
+                 elapsed.count(), as<double>(total) / elapsed.count() / 1e6);
+    return 0;
+  }
+
+  auto setup = [&](chip8::chip8& interpreter) {
+    if (options.count("rom") != 0) {
+      interpreter.load_rom(options["rom"].as<std::filesystem::path>());
+    }
+
+    if (options.count("ipf") != 0) {
+      interpreter.set_ipf(options["ipf"].as<std::uint64_t>());
+    }
+
+    if (seed) {
+      interpreter.seed(*seed);
+    }
+
+    interpreter.set_profile(profile);
+    interpreter.set_engine(engine);
+    interpreter.set_timer_period(timer_period);
+  };
+
+  if (options.count("record-video") != 0) {
+    auto format = chip8::video_format::raw;
+
+    if (options.count("video-format") != 0) {
+      auto name = options["video-format"].as<std::string>();
+      auto value = magic_enum::enum_cast<chip8::video_format>(name);
+
+      if (not value) {
+        fmt::println(stderr, "Invalid video format {}", name);
+        return 1;
+      }
+
+      format = *value;
+    }
+
+    auto name = options["record-video"].as<std::string>();
+    auto file = std::ofstream{};
+
+    if (name != "-") {
+      file.open(name, std::ios::binary);
+
+      if (not file) {
+        fmt::println(stderr, "Can't open {}", name);
+        return 1;
+      }
+    }
+
+    auto frames = options.count("frames") != 0
+                      ? options["frames"].as<std::uint64_t>()
+                      : chip8::fleet_config{}.frames;
+
+    auto writer =
+        chip8::video_writer{name == "-" ? std::cout : file, format};
+    auto interpreter = chip8::chip8{};
+
+    interpreter.set_display(writer);
+    setup(interpreter);
+
+    for (auto frame = 0ULL; frame < frames and not interpreter.is_invalid();
+         frame++) {
+      interpreter.exec_frame();
+    }
+
+    fmt::println(stderr, "Recorded {} frames, {} repeated", writer.frames(),
+                 writer.repeats());
+    return 0;
+  }
+
+  // Movies are tied to the ROM they were recorded with by its hash
+  auto movie_rom = std::uint64_t{};
+
+  if (options.count("record") != 0 or options.count("replay") != 0) {
+    if (options.count("rom") == 0) {
+      fmt::println(stderr, "Movies need the ROM given with --rom");
+      return 1;
+    }
+
+    auto rom = options["rom"].as<std::filesystem::path>();
+    auto hash = chip8::rom_hash(rom);
+
+    if (not hash) {
+      fmt::println(stderr, "Invalid rom file {}", rom.string());
+      return 1;
+    }
+
+    movie_rom = *hash;
+  }
+
+  if (options.count("replay") != 0) {
+    auto file = std::ifstream{options["replay"].as<std::filesystem::path>()};
+    auto recording = chip8::movie::load(file);
+
+    if (not recording) {
+      fmt::println(stderr, "Invalid movie file");
+      return 1;
+    }
+
+    auto rom = options["rom"].as<std::filesystem::path>();
+
+    if (movie_rom != recording->rom_hash) {
+      fmt::println(stderr, "{} isn't the ROM the movie was recorded with",
+                   rom.string());
+      return 1;
+    }
+
+    auto player = chip8::movie_player{*recording};
+    auto interpreter = chip8::chip8{};
+
+    interpreter.set_input(player);
+    interpreter.load_rom(rom);
+    interpreter.seed(recording->seed);
+    interpreter.set_profile(recording->cpu_profile);
+    interpreter.set_ipf(recording->ipf);
+    interpreter.set_timer_period(recording->timer_period);
+    interpreter.set_engine(engine);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (auto frame = 0ULL; frame < recording->frames; frame++) {
+      interpreter.exec_frame();
+    }
+
+    auto elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start);
+
+    fmt::println("Replayed {} frames in {:.3f}s, {:.1f} MIPS",
+                 recording->frames, elapsed.count(),
+                 as<double>(interpreter.instructions()) / elapsed.count() /
+                     1e6);
+
+    if (interpreter.state_hash() != recording->state_hash) {
+      fmt::println(stderr, "Final state {:016x} differs from recorded {:016x}",
+                   interpreter.state_hash(), recording->state_hash);
+      return 1;
+    }
+
+    return 0;
+  }
+
+  if (options.count("terminal") != 0) {
+    auto frontend = chip8::terminal_frontend{std::cout};
+    auto interpreter = chip8::chip8{};
+
+    interpreter.set_display(frontend);
 
-  if (options.count("rom") != 0) {
-    interpreter.load_rom(options["rom"].as<std::filesystem::path>());
+    setup(interpreter);
+    frontend.set_throttle(options.count("unthrottled") == 0);
+
+    interpreter.exec_all();
+    return 0;
+  }
+
+  auto keymap = chip8::raylib_frontend::DEFAULT_KEYMAP;
+
+  if (options.count("keymap") != 0) {
+    auto layout = options["keymap"].as<std::string>();
+    auto value = chip8::raylib_frontend::parse_keymap(layout);
+
+    if (not value) {
+      fmt::println(stderr, "Invalid keymap {}", layout);
+      return 1;
+    }
+
+    keymap = *value;
+  }
+
+  auto frontend = chip8::raylib_frontend{keymap};
+  auto recording = chip8::movie{};
+  auto recorder = chip8::movie_recorder{frontend, recording};
+  auto interpreter = chip8::chip8{};
+
+  interpreter.set_display(frontend);
+  interpreter.set_input(frontend);
+  interpreter.set_audio(frontend);
+
+  if (options.count("record") != 0) {
+    // Replays need the seed, so pick one now unless given
+    seed = seed.value_or(std::random_device{}());
+    interpreter.set_input(recorder);
+  }
+
+  setup(interpreter);
+  frontend.set_throttle(options.count("unthrottled") == 0);
+
+  // A movie only plays forwards, so there's no rewinding while recording one
+  if (options.count("rewind") != 0 and options.count("record") == 0) {
+    // Deltas between frames are mostly a few dozen bytes, the budget leaves
+    // room for busier programs
+    auto frames = options["rewind"].as<std::size_t>() * 60;
+    interpreter.set_rewind(frames, frames * 1024);
   }
 
   if (options.count("debug") != 0) {
@@ -39,5 +419,18 @@ auto main(int argc, char* argv[]) -> int {
     interpreter.exec_all();
   }
 
+  if (options.count("record") != 0) {
+    recording.seed = *seed;
+    recording.rom_hash = movie_rom;
+    recording.cpu_profile = profile;
+    recording.ipf = interpreter.ipf();
+    recording.timer_period = timer_period;
+    recording.frames = interpreter.frames();
+    recording.state_hash = interpreter.state_hash();
+
+    auto file = std::ofstream{options["record"].as<std::filesystem::path>()};
+    recording.save(file);
+  }
+
   return 0;
 }
@@ -0,0 +1,179 @@
+#include "movie.h"
+
+#include <fmt/format.h>
+
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <magic_enum/magic_enum.hpp>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "common.h"
+#include "helpers.h"
+#include "keyboard.h"
+#include "rom.h"
+
+namespace chip8 {
+namespace {
+constexpr auto MAGIC = "chip8-movie";
+constexpr auto VERSION = 1;
+}  // namespace
+
+auto movie::save(std::ostream& out) const -> void {
+  out << fmt::format("{} {}\n", MAGIC, VERSION);
+  out << fmt::format("seed {}\n", seed);
+  out << fmt::format("rom {:016x}\n", rom_hash);
+  out << fmt::format("profile {}\n", magic_enum::enum_name(cpu_profile));
+  out << fmt::format("ipf {}\n", ipf);
+  out << fmt::format("timer-period {}\n", timer_period);
+  out << fmt::format("frames {}\n", frames);
+  out << fmt::format("state {:016x}\n", state_hash);
+
+  for (const auto& [frame, keys] : inputs) {
+    out << fmt::format("{} {:04x}\n", frame, keys);
+  }
+}
+
+auto movie::load(std::istream& in) -> std::optional<movie> {
+  auto magic = std::string{};
+  auto version = 0;
+
+  in >> magic >> version;
+
+  if (magic != MAGIC or version != VERSION) {
+    return std::nullopt;
+  }
+
+  // A name and a value per header line, the inputs follow the state hash
+  auto fields = std::map<std::string, std::string>{};
+
+  for (auto name = std::string{}; name != "state" and in >> name;) {
+    in >> fields[name];
+  }
+
+  auto number = [&fields](const std::string& name,
+                          int base) -> std::optional<std::uint64_t> {
+    auto iter = fields.find(name);
+
+    if (iter == fields.end()) {
+      return std::nullopt;
+    }
+
+    const auto& text = iter->second;
+    const auto* last = text.data() + text.size();
+    auto value = std::uint64_t{};
+
+    auto [end, error] = std::from_chars(text.data(), last, value, base);
+
+    if (error != std::errc{} or end != last) {
+      return std::nullopt;
+    }
+
+    return value;
+  };
+
+  auto seed = number("seed", 10);
+  auto rom = number("rom", 16);
+  auto cpu_profile = magic_enum::enum_cast<profile>(fields["profile"]);
+  auto ipf = number("ipf", 10);
+  auto timer_period = number("timer-period", 10);
+  auto frames = number("frames", 10);
+  auto state = number("state", 16);
+
+  if (not seed or not rom or not cpu_profile or not ipf or not timer_period or
+      not frames or not state) {
+    return std::nullopt;
+  }
+
+  auto result = movie{
+      .seed = *seed,
+      .rom_hash = *rom,
+      .cpu_profile = *cpu_profile,
+      .ipf = *ipf,
+      .timer_period = *timer_period,
+      .frames = *frames,
+      .state_hash = *state,
+      .inputs = {},
+  };
+
+  auto change = movie_input{};
+
+  while (in >> std::dec >> change.frame >> std::hex >> change.keys) {
+    result.inputs.push_back(change);
+  }
+
+  return result;
+}
+
+auto rom_hash(std::span<const byte> rom) -> std::uint64_t {
+  auto result = 0xcbf29ce484222325ULL;
+
+  for (auto value : rom) {
+    result ^= value;
+    result *= 0x100000001b3ULL;
+  }
+
+  return result;
+}
+
+auto rom_hash(const std::filesystem::path& file)
+    -> std::optional<std::uint64_t> {
+  auto rom = read_rom(file);
+
+  if (not rom) {
+    return std::nullopt;
+  }
+
+  return rom_hash(*rom);
+}
+
+movie_recorder::movie_recorder(input& source, movie& out)
+    : m_source(&source), m_movie(&out) {}
+
+auto movie_recorder::poll(std::vector<key_event>& events) -> void {
+  auto first = events.size();
+  m_source->poll(events);
+
+  for (auto idx = first; idx < events.size(); idx++) {
+    auto bit = as<std::uint16_t>(1U << std::to_underlying(events[idx].key));
+    auto keys = events[idx].down ? m_keys | bit : m_keys & ~bit;
+
+    if (keys != m_keys) {
+      m_keys = as<std::uint16_t>(keys);
+      m_movie->inputs.push_back({.frame = m_frame, .keys = m_keys});
+    }
+  }
+
+  m_frame++;
+}
+
+movie_player::movie_player(const movie& value) : m_movie(&value) {}
+
+auto movie_player::poll(std::vector<key_event>& events) -> void {
+  const auto& inputs = m_movie->inputs;
+
+  for (; m_next < inputs.size() and inputs[m_next].frame == m_frame;
+       m_next++) {
+    auto changed = m_keys ^ inputs[m_next].keys;
+    m_keys = inputs[m_next].keys;
+
+    for (auto key = 0; key < 16; key++) {
+      if (((changed >> key) & 1) != 0) {
+        events.push_back({.at = 0,
+                          .key = as<keys>(key),
+                          .down = ((m_keys >> key) & 1) != 0});
+      }
+    }
+  }
+
+  m_frame++;
+}
+}  // namespace chip8
@@ -0,0 +1,80 @@
+#ifndef HK_CHIP8_MOVIE_H
+#define HK_CHIP8_MOVIE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <vector>
+
+#include "common.h"
+#include "frontend.h"
+#include "keyboard.h"
+#include "quirks.h"
+
+namespace chip8 {
+// Keys held after a change, one bit per key
+struct movie_input {
+  std::uint64_t frame;
+  std::uint16_t keys;
+
+  auto operator==(const movie_input& other) const -> bool = default;
+};
+
+// Everything needed to run a session again, and the state it ended in
+struct movie {
+  std::uint64_t seed{};
+  std::uint64_t rom_hash{};
+  profile cpu_profile{profile::vip};
+  std::uint64_t ipf{DEFAULT_IPF};
+  std::uint64_t timer_period{};
+
+  std::uint64_t frames{};
+  std::uint64_t state_hash{};
+
+  // In order, a tap shows up as two changes in the same frame
+  std::vector<movie_input> inputs{};
+
+  auto save(std::ostream& out) const -> void;
+  [[nodiscard]] static auto load(std::istream& in) -> std::optional<movie>;
+
+  auto operator==(const movie& other) const -> bool = default;
+};
+
+// FNV-1a over the ROM file, nothing if the file can't be read
+[[nodiscard]] auto rom_hash(std::span<const byte> rom) -> std::uint64_t;
+[[nodiscard]] auto rom_hash(const std::filesystem::path& file)
+    -> std::optional<std::uint64_t>;
+
+// Input passing another one through while writing every change down
+class movie_recorder final : public input {
+ public:
+  explicit movie_recorder(input& source, movie& out);
+
+  auto poll(std::vector<key_event>& events) -> void override;
+
+ private:
+  input* m_source;
+  movie* m_movie;
+  std::uint64_t m_frame{};
+  std::uint16_t m_keys{};
+};
+
+// Input feeding a recorded movie back, frame by frame
+class movie_player final : public input {
+ public:
+  explicit movie_player(const movie& value);
+
+  auto poll(std::vector<key_event>& events) -> void override;
+
+ private:
+  const movie* m_movie;
+  std::size_t m_next{};
+  std::uint64_t m_frame{};
+  std::uint16_t m_keys{};
+};
+}  // namespace chip8
+
+#endif
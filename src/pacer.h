@@ -0,0 +1,54 @@
+#ifndef HK_CHIP8_PACER_H
+#define HK_CHIP8_PACER_H
+
+#include <chrono>
+#include <cstdint>
+#include <ratio>
+#include <thread>
+
+namespace chip8 {
+// Wall clock pacing for frontends, the core itself never looks at the time.
+// Deadlines are whole 1/60 s periods from a fixed start, so rounding never
+// accumulates and the rate stays at 60 Hz.
+class pacer {
+ public:
+  using clock = std::chrono::steady_clock;
+  using frame = std::chrono::duration<std::int64_t, std::ratio<1, 60>>;
+
+  explicit pacer() : m_start(clock::now()) {}
+
+  // Sleep off whatever is left of the current frame
+  auto wait() -> void {
+    if (not m_enabled) {
+      return;
+    }
+
+    auto deadline =
+        m_start + std::chrono::duration_cast<clock::duration>(frame{++m_frames});
+
+    if (auto now = clock::now(); deadline < now) {
+      // Running behind, don't try to catch up on lost frames
+      m_start = now;
+      m_frames = 0;
+    } else {
+      std::this_thread::sleep_until(deadline);
+    }
+  }
+
+  // Disabled pacers return straight away
+  [[nodiscard]] auto enabled() const -> bool { return m_enabled; }
+
+  auto set_enabled(bool value) -> void {
+    m_enabled = value;
+    m_start = clock::now();
+    m_frames = 0;
+  }
+
+ private:
+  clock::time_point m_start;
+  std::int64_t m_frames{};
+  bool m_enabled{true};
+};
+}  // namespace chip8
+
+#endif
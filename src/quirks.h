@@ -0,0 +1,83 @@
+#ifndef HK_CHIP8_QUIRKS_H
+#define HK_CHIP8_QUIRKS_H
+
+#include "common.h"
+
+namespace chip8 {
+// Behaviour which differs between CHIP-8 variants. Handlers take these as a
+// template argument so each profile gets its own branch free instantiation.
+struct quirks {
+  // SHR and SHL shift VY into VX instead of shifting VX in place
+  bool shift_vy;
+  // LD [I], VX and LD VX, [I] leave I past the last register
+  bool increment_i;
+  // OR, AND and XOR clear VF
+  bool vf_reset;
+  // DRW clips sprites at the edge of the screen instead of wrapping them
+  bool clip;
+  // BNNN jumps to XNN + VX instead of NNN + V0
+  bool jump_vx;
+};
+
+enum class profile : byte {
+  // Original COSMAC VIP interpreter
+  vip,
+  // SUPER-CHIP 1.1
+  schip,
+  // XO-CHIP
+  xochip,
+};
+
+namespace profiles {
+constexpr auto vip = quirks{
+    .shift_vy = true,
+    .increment_i = true,
+    .vf_reset = true,
+    .clip = true,
+    .jump_vx = false,
+};
+
+constexpr auto schip = quirks{
+    .shift_vy = false,
+    .increment_i = false,
+    .vf_reset = false,
+    .clip = true,
+    .jump_vx = true,
+};
+
+constexpr auto xochip = quirks{
+    .shift_vy = true,
+    .increment_i = true,
+    .vf_reset = false,
+    .clip = false,
+    .jump_vx = false,
+};
+}  // namespace profiles
+
+constexpr auto get_quirks(profile value) -> quirks {
+  switch (value) {
+    case profile::schip:
+      return profiles::schip;
+    case profile::xochip:
+      return profiles::xochip;
+    default:
+      return profiles::vip;
+  }
+}
+
+// Calls fn.operator()<Q>() with the quirks of value, instantiating fn once
+// per profile
+template <typename Fn>
+constexpr auto with_quirks(profile value, Fn&& fn) -> decltype(auto) {
+  switch (value) {
+    case profile::schip:
+      return fn.template operator()<profiles::schip>();
+    case profile::xochip:
+      return fn.template operator()<profiles::xochip>();
+    default:
+      return fn.template operator()<profiles::vip>();
+  }
+}
+}  // namespace chip8
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef HK_CHIP8_RANDOM_H
+#define HK_CHIP8_RANDOM_H
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#include "common.h"
+#include "helpers.h"
+
+namespace chip8 {
+// SplitMix64, spreads a single seed over a larger generator state
+constexpr auto splitmix64(std::uint64_t& state) -> std::uint64_t {
+  auto result = (state += 0x9e3779b97f4a7c15ULL);
+
+  result = (result ^ (result >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  result = (result ^ (result >> 27)) * 0x94d049bb133111ebULL;
+
+  return result ^ (result >> 31);
+}
+
+// One xoshiro256** step. The state words are separate so a batch can keep
+// one array per word.
+constexpr auto xoshiro256(std::uint64_t& s0, std::uint64_t& s1,
+                          std::uint64_t& s2, std::uint64_t& s3)
+    -> std::uint64_t {
+  auto result = std::rotl(s1 * 5, 7) * 9;
+  auto temp = s1 << 17;
+
+  s2 ^= s0;
+  s3 ^= s1;
+  s1 ^= s2;
+  s0 ^= s3;
+  s2 ^= temp;
+  s3 = std::rotl(s3, 45);
+
+  return result;
+}
+
+// Byte source behind RND
+class random_source {
+ public:
+  virtual ~random_source() = default;
+
+  virtual auto seed(std::uint64_t value) -> void = 0;
+  virtual auto next() -> byte = 0;
+};
+
+// Default source, no system calls after seeding
+class xoshiro final : public random_source {
+ public:
+  explicit xoshiro(std::uint64_t value) { seed(value); }
+
+  auto seed(std::uint64_t value) -> void override {
+    for (auto& word : m_state) {
+      word = splitmix64(value);
+    }
+  }
+
+  auto next() -> byte override {
+    auto value = xoshiro256(m_state[0], m_state[1], m_state[2], m_state[3]);
+
+    // The high bits are the strongest
+    return as<byte>(value >> 56);
+  }
+
+ private:
+  std::array<std::uint64_t, 4> m_state{};
+};
+}  // namespace chip8
+
+#endif
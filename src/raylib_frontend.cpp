@@ -0,0 +1,245 @@
+#include "raylib_frontend.h"
+
+#include <raylib.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stop_token>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "common.h"
+#include "helpers.h"
+#include "keyboard.h"
+#include "screen.h"
+
+#define BG_COLOR PINK
+#define FG_COLOR MAROON
+
+namespace chip8 {
+namespace {
+constexpr auto PIXEL = 10;
+constexpr auto FPS = 60;
+
+constexpr auto SAMPLE_RATE = 44100U;
+
+// One period of a 441 Hz square wave, the audio callback only copies it
+constexpr auto WAVE = [] {
+  constexpr auto VOLUME = std::int16_t{4000};
+
+  auto result = std::array<std::int16_t, SAMPLE_RATE / 441>{};
+
+  for (auto idx = 0UZ; idx < result.size(); idx++) {
+    result.at(idx) = idx < result.size() / 2 ? VOLUME : -VOLUME;
+  }
+
+  return result;
+}();
+
+// raylib audio callbacks get no user pointer, there is only one window
+// anyway. Written by the emulation thread, read by the audio thread.
+std::atomic<bool> tone_on;
+
+// Audio thread only. It holds still while the tone is off, so the wave
+// carries on where it stopped when the tone comes back.
+std::size_t phase;
+
+auto fill(void* buffer, unsigned int frames) -> void {
+  auto* out = static_cast<std::int16_t*>(buffer);
+
+  if (not tone_on.load(std::memory_order_relaxed)) {
+    std::fill_n(out, frames, std::int16_t{});
+    return;
+  }
+
+  for (auto idx = 0U; idx < frames; idx++) {
+    out[idx] = WAVE.at(phase);
+    phase = (phase + 1) % WAVE.size();
+  }
+}
+}  // namespace
+
+// Rows of the COSMAC VIP keypad, 123C 456D 789E A0BF, on the left of a
+// QWERTY keyboard
+const raylib_frontend::keymap raylib_frontend::DEFAULT_KEYMAP{
+    KEY_X, KEY_ONE, KEY_TWO, KEY_THREE, KEY_Q, KEY_W, KEY_E, KEY_A,
+    KEY_S, KEY_D,   KEY_Z,   KEY_C,     KEY_FOUR, KEY_R, KEY_F, KEY_V,
+};
+
+auto raylib_frontend::parse_keymap(std::string_view layout)
+    -> std::optional<keymap> {
+  if (layout.size() != keymap{}.size()) {
+    return std::nullopt;
+  }
+
+  auto result = keymap{};
+
+  for (auto idx = 0UZ; idx < layout.size(); idx++) {
+    auto letter = as<unsigned char>(layout[idx]);
+
+    if (not std::isalnum(letter)) {
+      return std::nullopt;
+    }
+
+    // raylib codes letters and digits by their upper case ASCII value
+    result.at(idx) = std::toupper(letter);
+  }
+
+  return result;
+}
+
+raylib_frontend::raylib_frontend(const keymap& layout)
+    : m_keymap(layout),
+      m_lookup(lookup(layout)),
+      m_thread([this](const std::stop_token& stop) { render(stop); }) {}
+
+auto raylib_frontend::lookup(const keymap& layout) -> key_lookup {
+  auto result = key_lookup{};
+
+  for (auto key = 0UZ; key < layout.size(); key++) {
+    result.at(layout.at(key)) = as<keys>(key);
+  }
+
+  return result;
+}
+
+raylib_frontend::~raylib_frontend() = default;
+
+auto raylib_frontend::present(const screen& value) -> void {
+  // Unchanged frames aren't handed over, the window keeps the last one
+  if (value.dirty()) {
+    m_frames.back() = value;
+    m_frames.publish();
+  }
+
+  m_pacer.wait();
+}
+
+auto raylib_frontend::closed() -> bool {
+  return m_closed.load(std::memory_order_relaxed);
+}
+
+auto raylib_frontend::poll(std::vector<key_event>& events) -> void {
+  while (auto event = m_events.pop()) {
+    events.push_back(*event);
+  }
+}
+
+auto raylib_frontend::rewinding() -> bool {
+  return m_rewinding.load(std::memory_order_relaxed);
+}
+
+auto raylib_frontend::render(const std::stop_token& stop) -> void {
+  SetTraceLogLevel(LOG_WARNING);
+  InitWindow(WIDTH * PIXEL, HEIGHT * PIXEL, "hellokartikey - CHIP8 Emulator");
+
+  // EndDrawing() paces the render thread, independent of emulation, and
+  // WaitTime() stands in for it on frames with nothing new to draw
+  SetTargetFPS(FPS);
+
+  m_pixels.fill(BG_COLOR);
+
+  auto image = GenImageColor(WIDTH, HEIGHT, BG_COLOR);
+  m_canvas = LoadTextureFromImage(image);
+  UnloadImage(image);
+
+  // Keep pixels square when scaled up
+  SetTextureFilter(m_canvas, TEXTURE_FILTER_POINT);
+
+  // raylib pulls samples from its own thread, so pacing doesn't matter
+  InitAudioDevice();
+
+  // Short buffers keep the beep within a frame of the sound timer
+  SetAudioStreamBufferSizeDefault(512);
+
+  auto beeper = LoadAudioStream(SAMPLE_RATE, 16, 1);
+  SetAudioStreamCallback(beeper, fill);
+  PlayAudioStream(beeper);
+
+  auto held = std::bitset<16>{};
+
+  while (not stop.stop_requested()) {
+    if (WindowShouldClose()) {
+      m_closed.store(true, std::memory_order_relaxed);
+      break;
+    }
+
+    // Presses come in order from raylib's queue, releases are found from
+    // the key state. held only follows changes the queue took, anything it
+    // had no room for is sent again from the key state on a later frame.
+    for (auto code = GetKeyPressed(); code != KEY_NULL;
+         code = GetKeyPressed()) {
+      auto key = code < KEY_CODES ? m_lookup.at(code) : std::nullopt;
+
+      if (key and not held.test(std::to_underlying(*key)) and
+          m_events.push(key_event{.at = 0, .key = *key, .down = true})) {
+        held.set(std::to_underlying(*key));
+      }
+    }
+
+    for (auto idx = 0UZ; idx < held.size(); idx++) {
+      auto down = IsKeyDown(m_keymap.at(idx));
+
+      if (down != held.test(idx) and
+          m_events.push(
+              key_event{.at = 0, .key = as<keys>(idx), .down = down})) {
+        held.set(idx, down);
+      }
+    }
+
+    m_rewinding.store(IsKeyDown(KEY_BACKSPACE), std::memory_order_relaxed);
+
+    if (not m_frames.update()) {
+      // Nothing new to show, the window keeps the last frame
+      PollInputEvents();
+      WaitTime(1.0 / FPS);
+      continue;
+    }
+
+    // Frames in between may have been skipped, so redraw every row
+    draw(m_frames.front());
+
+    BeginDrawing();
+
+    DrawTexturePro(m_canvas, Rectangle{0, 0, WIDTH, HEIGHT},
+                   Rectangle{0, 0, WIDTH * PIXEL, HEIGHT * PIXEL},
+                   Vector2{0, 0}, 0, WHITE);
+
+    EndDrawing();
+  }
+
+  UnloadAudioStream(beeper);
+  CloseAudioDevice();
+
+  UnloadTexture(m_canvas);
+  CloseWindow();
+}
+
+auto raylib_frontend::draw(const screen& value) -> void {
+  // Same cost however many pixels are lit, one upload per frame
+  for (auto row = 0; row < HEIGHT; row++) {
+    for (auto col = 0; col < WIDTH; col++) {
+      m_pixels[(row * WIDTH) + col] = value[col, row] ? FG_COLOR : BG_COLOR;
+    }
+  }
+
+  UpdateTexture(m_canvas, m_pixels.data());
+}
+
+auto raylib_frontend::tone(bool on) -> void {
+  tone_on.store(on, std::memory_order_relaxed);
+}
+
+auto raylib_frontend::throttled() const -> bool { return m_pacer.enabled(); }
+
+auto raylib_frontend::set_throttle(bool value) -> void {
+  m_pacer.set_enabled(value);
+}
+}  // namespace chip8
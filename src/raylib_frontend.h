@@ -0,0 +1,94 @@
+#ifndef HK_CHIP8_RAYLIB_FRONTEND_H
+#define HK_CHIP8_RAYLIB_FRONTEND_H
+
+#include <raylib.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <stop_token>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "frontend.h"
+#include "keyboard.h"
+#include "pacer.h"
+#include "screen.h"
+#include "spsc_queue.h"
+#include "triple_buffer.h"
+
+namespace chip8 {
+// Window, keyboard and speaker through raylib. The window is open for the
+// lifetime of the object and owned by a render thread, so the emulation
+// thread never waits on the GPU. Frames go over through a triple buffer and
+// key changes come back through a lock free queue.
+class raylib_frontend final : public display, public input, public audio {
+ public:
+  // Host key for each CHIP-8 key, 0 through F
+  using keymap = std::array<int, 16>;
+
+  static const keymap DEFAULT_KEYMAP;
+
+  // One letter or digit per CHIP-8 key, 0 through F
+  [[nodiscard]] static auto parse_keymap(std::string_view layout)
+      -> std::optional<keymap>;
+
+  explicit raylib_frontend(const keymap& layout = DEFAULT_KEYMAP);
+  ~raylib_frontend() override;
+
+  raylib_frontend(const raylib_frontend&) = delete;
+  raylib_frontend(raylib_frontend&&) = delete;
+
+  auto operator=(const raylib_frontend&) -> raylib_frontend& = delete;
+  auto operator=(raylib_frontend&&) -> raylib_frontend& = delete;
+
+  auto present(const screen& value) -> void override;
+  [[nodiscard]] auto closed() -> bool override;
+
+  auto poll(std::vector<key_event>& events) -> void override;
+
+  // While Backspace is held
+  [[nodiscard]] auto rewinding() -> bool override;
+
+  auto tone(bool on) -> void override;
+
+  // Hold emulated frames to 60 Hz, on by default
+  [[nodiscard]] auto throttled() const -> bool;
+  auto set_throttle(bool value) -> void;
+
+ private:
+  // Render thread, everything touching raylib runs here
+  auto render(const std::stop_token& stop) -> void;
+  auto draw(const screen& value) -> void;
+
+  // Emulation thread
+  pacer m_pacer;
+
+  // Shared
+  triple_buffer<screen> m_frames;
+  spsc_queue<key_event, 256> m_events;
+  std::atomic<bool> m_closed{};
+  std::atomic<bool> m_rewinding{};
+
+  // Render thread, the CHIP-8 key for every host key code
+  static constexpr auto KEY_CODES = 512Z;
+  using key_lookup = std::array<std::optional<keys>, KEY_CODES>;
+
+  [[nodiscard]] static auto lookup(const keymap& layout) -> key_lookup;
+
+  keymap m_keymap;
+  key_lookup m_lookup;
+
+  // Render thread, last presented screen with one texel per pixel and scaled
+  // up when drawn
+  std::array<Color, WIDTH * HEIGHT> m_pixels{};
+  Texture2D m_canvas{};
+
+  // Last, so it stops before anything it uses goes away
+  std::jthread m_thread;
+};
+}  // namespace chip8
+
+#endif
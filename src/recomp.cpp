@@ -0,0 +1,71 @@
+#include <fmt/base.h>
+
+#include <cxxopts.hpp>
+#include <filesystem>
+#include <fstream>
+#include <magic_enum/magic_enum.hpp>
+#include <string>
+
+#include "chip8.h"
+#include "common.h"
+#include "quirks.h"
+#include "recompiler.h"
+#include "rom.h"
+
+auto main(int argc, char* argv[]) -> int {
+  auto args = cxxopts::Options("chip8-recomp");
+
+  // clang-format off
+  args.add_options()
+    ("h,help", "Display help")
+    ("r,rom", "ROM file to recompile", cxxopts::value<std::filesystem::path>())
+    ("o,output", "Generated C++ file", cxxopts::value<std::filesystem::path>())
+    ("p,profile", "Quirks profile: vip, schip or xochip",
+      cxxopts::value<std::string>())
+  ;
+  // clang-format on
+
+  auto options = args.parse(argc, argv);
+
+  if (options.count("help") != 0 or options.count("rom") == 0 or
+      options.count("output") == 0) {
+    fmt::println(stderr, "{}", args.help());
+    return 1;
+  }
+
+  auto profile = chip8::profile::vip;
+
+  if (options.count("profile") != 0) {
+    auto name = options["profile"].as<std::string>();
+    auto value = magic_enum::enum_cast<chip8::profile>(name);
+
+    if (not value) {
+      fmt::println(stderr, "Invalid profile {}", name);
+      return 1;
+    }
+
+    profile = *value;
+  }
+
+  auto path = options["rom"].as<std::filesystem::path>();
+  auto rom = chip8::read_rom(path);
+
+  if (not rom) {
+    fmt::println(stderr, "Invalid rom file path");
+    return 1;
+  }
+
+  auto interpreter = chip8::chip8{};
+  interpreter.load_rom(*rom);
+
+  auto blocks = chip8::recover_blocks(interpreter.dump_memory(), chip8::word{0x0200});
+  auto source = chip8::emit_translation_unit(path.filename().string(), *rom,
+                                             blocks, profile);
+
+  auto output = std::ofstream{options["output"].as<std::filesystem::path>()};
+  output << source;
+
+  fmt::println("Recompiled {} blocks from {}", blocks.size(), path.string());
+
+  return 0;
+}
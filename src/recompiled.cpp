@@ -0,0 +1,70 @@
+#include "recompiled.h"
+
+#include <fmt/base.h>
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "block_cache.h"
+#include "chip8.h"
+#include "common.h"
+#include "differential.h"
+#include "quirks.h"
+#include "raylib_frontend.h"
+
+namespace chip8 {
+auto run_recompiled(std::span<const byte> rom,
+                    std::span<const native_entry> blocks, profile value,
+                    int argc, char* argv[]) -> int {
+  auto args = std::span{argv, static_cast<std::size_t>(argc)};
+
+  // --check N runs N instructions headless next to the reference
+  // interpreter instead of opening a window
+  if (args.size() > 2 and std::string_view{args[1]} == "--check") {
+    auto count = std::stoull(args[2]);
+    auto subject = chip8{};
+    auto reference = chip8{};
+
+    for (auto* side : {&subject, &reference}) {
+      side->seed(0);
+      side->load_rom(rom);
+      side->set_profile(value);
+    }
+
+    subject.set_engine(engine::recompiled);
+    subject.install_native(blocks);
+
+    if (auto diff = run_lockstep(subject, reference, count)) {
+      fmt::println(stderr, "Diverged within {} instructions: {}",
+                   diff->executed, diff->reason);
+      return 1;
+    }
+
+    fmt::println("No divergence in {} instructions", count);
+    return 0;
+  }
+
+  auto frontend = raylib_frontend{};
+  auto interpreter = chip8{};
+
+  interpreter.set_display(frontend);
+  interpreter.set_input(frontend);
+  interpreter.set_audio(frontend);
+
+  interpreter.load_rom(rom);
+  interpreter.set_profile(value);
+  interpreter.set_engine(engine::recompiled);
+  interpreter.install_native(blocks);
+
+  // Only the frame budget can be tuned, everything else is baked in
+  if (args.size() > 1) {
+    interpreter.set_ipf(std::stoull(args[1]));
+  }
+
+  interpreter.exec_all();
+
+  return 0;
+}
+}  // namespace chip8
@@ -0,0 +1,19 @@
+#ifndef HK_CHIP8_RECOMPILED_H
+#define HK_CHIP8_RECOMPILED_H
+
+#include <span>
+
+#include "block_cache.h"
+#include "common.h"
+#include "quirks.h"
+
+namespace chip8 {
+// Entry point of executables generated by chip8-recomp. Takes the
+// instructions per frame, or --check N to compare N instructions against the
+// reference interpreter headless.
+auto run_recompiled(std::span<const byte> rom,
+                    std::span<const native_entry> blocks, profile value,
+                    int argc, char* argv[]) -> int;
+}  // namespace chip8
+
+#endif
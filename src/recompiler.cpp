@@ -0,0 +1,346 @@
+#include "recompiler.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "block_cache.h"
+#include "common.h"
+#include "dispatch.h"
+#include "helpers.h"
+#include "quirks.h"
+
+namespace chip8 {
+namespace {
+// Addresses the block can continue at
+auto successors(const basic_block& block) -> std::vector<word> {
+  const auto& last = block.ops.back();
+  auto next = address(block.end);
+  auto skip = address(block.end + 2);
+
+  switch (last.op) {
+    case operation::JP:
+      return {last.addr};
+    case operation::CALL:
+      return {last.addr, next};
+    case operation::SE_BYTE:
+    case operation::SNE_BYTE:
+    case operation::SE_REGS:
+    case operation::SNE_REGS:
+    case operation::SKP:
+    case operation::SKNP:
+      return {next, skip};
+    case operation::RET:
+    case operation::JP_V0:
+    case operation::INVALID:
+      return {};
+    default:
+      return {next};
+  }
+}
+
+auto writes_memory(operation op) -> bool {
+  return op == operation::LD_B or op == operation::LD_I_VX;
+}
+
+// Instructions emitted as plain C++, the rest call the interpreter handler
+auto is_inline(operation op) -> bool {
+  switch (op) {
+    case operation::JP:
+    case operation::SE_BYTE:
+    case operation::SNE_BYTE:
+    case operation::SE_REGS:
+    case operation::SNE_REGS:
+    case operation::LD_BYTE:
+    case operation::ADD_BYTE:
+    case operation::LD_REGS:
+    case operation::OR:
+    case operation::AND:
+    case operation::XOR:
+    case operation::ADD_REGS:
+    case operation::SUB:
+    case operation::SUBN:
+    case operation::SHR:
+    case operation::SHL:
+    case operation::LD_I:
+    case operation::ADD_I:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Inline instructions which set the program counter themselves
+auto is_branch(operation op) -> bool {
+  switch (op) {
+    case operation::JP:
+    case operation::SE_BYTE:
+    case operation::SNE_BYTE:
+    case operation::SE_REGS:
+    case operation::SNE_REGS:
+      return true;
+    default:
+      return false;
+  }
+}
+
+auto reg(regs value) -> std::string {
+  return fmt::format("v[0x{:x}]", as<int>(value));
+}
+
+// C++ statements for one instruction, next is the address after it
+auto emit_instruction(const decoded_instruction& inst, word next,
+                      const quirks& quirks) -> std::string {
+  auto reg_x = reg(inst.reg_x);
+  auto reg_y = reg(inst.reg_y);
+  auto skip = address(next + 2);
+
+  auto reset = quirks.vf_reset ? "  v[0xf] = 0x00;\n" : "";
+  auto shift_src = quirks.shift_vy ? reg_y : reg_x;
+
+  switch (inst.op) {
+    case operation::JP:
+      return fmt::format("  *pc = 0x{:03x};\n", inst.addr);
+    case operation::SE_BYTE:
+      return fmt::format("  *pc = {} == 0x{:02x} ? 0x{:03x} : 0x{:03x};\n",
+                         reg_x, inst.lo_byte, skip, next);
+    case operation::SNE_BYTE:
+      return fmt::format("  *pc = {} != 0x{:02x} ? 0x{:03x} : 0x{:03x};\n",
+                         reg_x, inst.lo_byte, skip, next);
+    case operation::SE_REGS:
+      return fmt::format("  *pc = {} == {} ? 0x{:03x} : 0x{:03x};\n", reg_x,
+                         reg_y, skip, next);
+    case operation::SNE_REGS:
+      return fmt::format("  *pc = {} != {} ? 0x{:03x} : 0x{:03x};\n", reg_x,
+                         reg_y, skip, next);
+    case operation::LD_BYTE:
+      return fmt::format("  {} = 0x{:02x};\n", reg_x, inst.lo_byte);
+    case operation::ADD_BYTE:
+      return fmt::format("  {0} = static_cast<byte>({0} + 0x{1:02x});\n",
+                         reg_x, inst.lo_byte);
+    case operation::LD_REGS:
+      return fmt::format("  {} = {};\n", reg_x, reg_y);
+    case operation::OR:
+      return fmt::format("  {} |= {};\n{}", reg_x, reg_y, reset);
+    case operation::AND:
+      return fmt::format("  {} &= {};\n{}", reg_x, reg_y, reset);
+    case operation::XOR:
+      return fmt::format("  {} ^= {};\n{}", reg_x, reg_y, reset);
+    case operation::ADD_REGS:
+      return fmt::format(
+          "  res = {0} + {1};\n"
+          "  {0} = static_cast<byte>(res);\n"
+          "  v[0xf] = res > 0xff ? 0x01 : 0x00;\n",
+          reg_x, reg_y);
+    case operation::SUB:
+      return fmt::format(
+          "  flag = {0} >= {1} ? 0x01 : 0x00;\n"
+          "  {0} = static_cast<byte>({0} - {1});\n"
+          "  v[0xf] = flag;\n",
+          reg_x, reg_y);
+    case operation::SUBN:
+      return fmt::format(
+          "  flag = {1} >= {0} ? 0x01 : 0x00;\n"
+          "  {0} = static_cast<byte>({1} - {0});\n"
+          "  v[0xf] = flag;\n",
+          reg_x, reg_y);
+    case operation::SHR:
+      return fmt::format(
+          "  flag = {1} & 0x01;\n"
+          "  {0} = {1} >> 1;\n"
+          "  v[0xf] = flag;\n",
+          reg_x, shift_src);
+    case operation::SHL:
+      return fmt::format(
+          "  flag = {1} >> 7;\n"
+          "  {0} = static_cast<byte>({1} << 1);\n"
+          "  v[0xf] = flag;\n",
+          reg_x, shift_src);
+    case operation::LD_I:
+      return fmt::format("  *reg_i = 0x{:03x};\n", inst.addr);
+    case operation::ADD_I:
+      return fmt::format("  *reg_i = static_cast<word>(*reg_i + {});\n",
+                         reg_x);
+    default:
+      return fmt::format(
+          "  *pc = 0x{0:03x};\n"
+          "  op_{1:03x}.exec(*cpu, op_{1:03x});\n",
+          next, address(next - 2));
+  }
+}
+
+// Interpreter handlers for instructions which aren't emitted inline, blocks
+// may overlap so each address is declared once
+auto emit_handlers(std::span<const basic_block> blocks, profile value)
+    -> std::string {
+  auto handlers = std::map<word, word>{};
+
+  for (const auto& block : blocks) {
+    auto addr = block.start;
+
+    for (const auto& inst : block.ops) {
+      if (not is_inline(inst.op)) {
+        handlers.emplace(addr, inst.opcode);
+      }
+
+      addr = address(addr + 2);
+    }
+  }
+
+  auto out = std::string{"\n"};
+  for (const auto& [addr, opcode] : handlers) {
+    out += fmt::format(
+        "const auto op_{:03x} = chip8::decode(0x{:04x}, "
+        "chip8::profile::{});\n",
+        addr, opcode, as<std::string_view>(value));
+  }
+
+  return out;
+}
+
+auto emit_block(const basic_block& block, const quirks& quirks)
+    -> std::string {
+  auto body = std::string{};
+
+  auto pc = block.start;
+  auto count = 0UZ;
+
+  for (const auto& inst : block.ops) {
+    auto addr = pc;
+    pc = address(pc + 2);
+    count++;
+
+    body += fmt::format("  // {:03x}: {:04x}\n", addr, inst.opcode);
+    body += emit_instruction(inst, pc, quirks);
+
+    // A write to memory may have patched the rest of this block
+    if (writes_memory(inst.op) and count != block.ops.size()) {
+      body += fmt::format(
+          "  if (cpu->code_epoch() != epoch) {{\n"
+          "    return {};\n"
+          "  }}\n",
+          count);
+    }
+  }
+
+  // Handlers already moved the program counter past the last instruction
+  const auto& last = block.ops.back().op;
+  if (is_inline(last) and not is_branch(last)) {
+    body += fmt::format("  *pc = 0x{:03x};\n", pc);
+  }
+
+  return fmt::format(
+      "\n"
+      "auto block_{0:03x}([[maybe_unused]] chip8::chip8* cpu,\n"
+      "               [[maybe_unused]] byte* v,\n"
+      "               [[maybe_unused]] word* reg_i, word* pc)\n"
+      "    -> std::uint32_t {{\n"
+      "  [[maybe_unused]] const auto epoch = cpu->code_epoch();\n"
+      "  [[maybe_unused]] auto res = 0;\n"
+      "  [[maybe_unused]] auto flag = byte{{}};\n"
+      "\n"
+      "{1}"
+      "\n"
+      "  return {2};\n"
+      "}}\n",
+      block.start, body, count);
+}
+}  // namespace
+
+auto recover_blocks(const memory& mem, word start) -> std::vector<basic_block> {
+  auto blocks = std::map<word, basic_block>{};
+  auto pending = std::vector<word>{start};
+
+  while (not pending.empty()) {
+    auto addr = pending.back();
+    pending.pop_back();
+
+    if (blocks.contains(addr)) {
+      continue;
+    }
+
+    auto block = block_cache::translate(addr, mem);
+    auto next = successors(block);
+
+    blocks.emplace(addr, std::move(block));
+    std::ranges::copy(next, std::back_inserter(pending));
+  }
+
+  auto result = std::vector<basic_block>{};
+  for (auto& [addr, block] : blocks) {
+    result.push_back(std::move(block));
+  }
+
+  return result;
+}
+
+auto emit_translation_unit(std::string_view name, std::span<const byte> rom,
+                           std::span<const basic_block> blocks, profile value)
+    -> std::string {
+  auto out = fmt::format(
+      "// Generated by chip8-recomp from {}, do not edit\n"
+      "\n"
+      "#include <array>\n"
+      "#include <cstdint>\n"
+      "\n"
+      "#include \"chip8.h\"\n"
+      "#include \"common.h\"\n"
+      "#include \"dispatch.h\"\n"
+      "#include \"recompiled.h\"\n"
+      "\n"
+      "namespace {{\n"
+      "using chip8::byte;\n"
+      "using chip8::word;\n",
+      name);
+
+  out += emit_handlers(blocks, value);
+
+  for (const auto& block : blocks) {
+    out += emit_block(block, get_quirks(value));
+  }
+
+  out += "\nconst auto rom = std::to_array<byte>({";
+  for (auto idx = 0UZ; idx < rom.size(); idx++) {
+    out += fmt::format("{}0x{:02x},", idx % 12 == 0 ? "\n    " : " ",
+                       rom[idx]);
+  }
+  out += "\n});\n";
+
+  // Bytes each block was translated from, checked before it is attached
+  for (const auto& block : blocks) {
+    out += fmt::format("\nconst auto source_{:03x} = std::to_array<byte>({{",
+                       block.start);
+    for (auto idx = 0UZ; idx < block.ops.size(); idx++) {
+      auto opcode = block.ops[idx].opcode;
+      out += fmt::format("{}0x{:02x}, 0x{:02x},",
+                         idx % 6 == 0 ? "\n    " : " ", opcode >> 8,
+                         opcode & 0xff);
+    }
+    out += "\n});\n";
+  }
+
+  out += "\nconst auto blocks = std::to_array<chip8::native_entry>({\n";
+  for (const auto& block : blocks) {
+    out += fmt::format(
+        "    {{0x{0:03x}, {1}, source_{0:03x}, &block_{0:03x}}},\n",
+        block.start, block.ops.size());
+  }
+  out += "});\n}  // namespace\n";
+
+  out += fmt::format(
+      "\n"
+      "auto main(int argc, char* argv[]) -> int {{\n"
+      "  return chip8::run_recompiled(rom, blocks, chip8::profile::{}, argc,\n"
+      "                               argv);\n"
+      "}}\n",
+      as<std::string_view>(value));
+
+  return out;
+}
+}  // namespace chip8
@@ -0,0 +1,28 @@
+#ifndef HK_CHIP8_RECOMPILER_H
+#define HK_CHIP8_RECOMPILER_H
+
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "block_cache.h"
+#include "common.h"
+#include "quirks.h"
+
+namespace chip8 {
+// Blocks reachable from start by following JP, CALL and skip edges, sorted
+// by address. JP V0 targets can't be known ahead of time and are left out.
+[[nodiscard]] auto recover_blocks(const memory& mem, word start)
+    -> std::vector<basic_block>;
+
+// C++ translation unit with one function per block and a main() running the
+// program with those blocks installed, quirks are baked in for value
+[[nodiscard]] auto emit_translation_unit(std::string_view name,
+                                         std::span<const byte> rom,
+                                         std::span<const basic_block> blocks,
+                                         profile value = profile::vip)
+    -> std::string;
+}  // namespace chip8
+
+#endif
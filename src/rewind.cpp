@@ -0,0 +1,203 @@
+#include "rewind.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+
+#include "machine_state.h"
+
+namespace chip8 {
+rewind_buffer::rewind_buffer(std::size_t frames, std::size_t bytes,
+                             std::size_t interval)
+    : m_interval(std::max<std::size_t>(interval, 1)),
+      m_entries(std::max<std::size_t>(frames, 2)),
+      // Room for two whole states at least, so there's always one to go back
+      // to
+      m_data(std::max(bytes / sizeof(std::uint64_t), 2 * WORDS)),
+      // A header word per run, in the worst case one for every literal
+      m_scratch((2 * WORDS) + 1) {}
+
+auto rewind_buffer::push(const machine_state& state) -> void {
+  auto current = std::as_bytes(std::span{&state, 1});
+
+  auto size = 0UZ;
+  auto key = m_count == 0 or m_since_key + 1 >= m_interval;
+
+  // A zero run and a literal run after each header word, m_last picks up the
+  // literals as they are found
+  for (auto idx = 0UZ; not key and idx < WORDS;) {
+    auto zeros = idx;
+
+    // Most of the state stays put between frames, skip it a block at a time
+    while (idx + BLOCK <= WORDS and unchanged(current, idx)) {
+      idx += BLOCK;
+    }
+
+    while (idx < WORDS and delta(current, idx) == 0) {
+      idx++;
+    }
+
+    auto header = size++;
+    auto literals = idx;
+
+    for (auto value = std::uint64_t{};
+         idx < WORDS and (value = delta(current, idx)) != 0; idx++) {
+      m_scratch[size++] = value;
+      m_last[idx] ^= value;
+    }
+
+    m_scratch[header] = ((literals - zeros) << 32) | (idx - literals);
+
+    // Changed so much a whole state is smaller
+    key = size >= WORDS;
+  }
+
+  if (not key) {
+    make_room(size);
+
+    // The key this delta needs was dropped to make room
+    key = m_count == 0;
+  }
+
+  if (key) {
+    m_last = std::bit_cast<words>(state);
+    make_room(WORDS);
+    store(m_last.data(), WORDS, true);
+  } else {
+    store(m_scratch.data(), size, false);
+  }
+}
+
+auto rewind_buffer::step_back() -> std::optional<machine_state> {
+  if (m_count < 2) {
+    return std::nullopt;
+  }
+
+  auto newest = at(m_count - 1);
+
+  m_count--;
+  m_used -= newest.size;
+
+  if (not newest.key) {
+    // XOR both ways, the delta takes the newest state back a frame
+    load(newest);
+    apply(newest.size);
+    m_since_key--;
+  } else {
+    // Replay the deltas after the key before it
+    auto key = m_count - 1;
+
+    while (not at(key).key) {
+      key--;
+    }
+
+    load(at(key));
+    std::copy_n(m_scratch.begin(), WORDS, m_last.begin());
+
+    for (auto idx = key + 1; idx < m_count; idx++) {
+      load(at(idx));
+      apply(at(idx).size);
+    }
+
+    m_since_key = m_count - 1 - key;
+  }
+
+  return std::bit_cast<machine_state>(m_last);
+}
+
+auto rewind_buffer::clear() -> void {
+  m_first = 0;
+  m_count = 0;
+  m_since_key = 0;
+  m_start = 0;
+  m_used = 0;
+}
+
+auto rewind_buffer::frames() const -> std::size_t { return m_count; }
+
+auto rewind_buffer::bytes() const -> std::size_t {
+  return m_used * sizeof(std::uint64_t);
+}
+
+auto rewind_buffer::delta(std::span<const std::byte> state,
+                          std::size_t idx) const -> std::uint64_t {
+  auto value = std::uint64_t{};
+  std::memcpy(&value, state.data() + (idx * sizeof(value)), sizeof(value));
+
+  return value ^ m_last[idx];
+}
+
+auto rewind_buffer::unchanged(std::span<const std::byte> state,
+                              std::size_t idx) const -> bool {
+  auto changed = std::uint64_t{};
+
+  for (auto offset = 0UZ; offset < BLOCK; offset++) {
+    changed |= delta(state, idx + offset);
+  }
+
+  return changed == 0;
+}
+
+auto rewind_buffer::make_room(std::size_t size) -> void {
+  while (m_count != 0 and
+         (m_count == m_entries.size() or m_used + size > m_data.size())) {
+    drop_oldest();
+  }
+}
+
+auto rewind_buffer::drop_oldest() -> void {
+  // Deltas are useless without the key before them, so they go too
+  do {
+    m_start = (m_start + at(0).size) % m_data.size();
+    m_used -= at(0).size;
+    m_first = (m_first + 1) % m_entries.size();
+    m_count--;
+  } while (m_count != 0 and not at(0).key);
+}
+
+auto rewind_buffer::store(const std::uint64_t* data, std::size_t size,
+                          bool key) -> void {
+  auto offset = (m_start + m_used) % m_data.size();
+  auto first = std::min(size, m_data.size() - offset);
+
+  std::copy_n(data, first, m_data.begin() + offset);
+  std::copy_n(data + first, size - first, m_data.begin());
+
+  m_entries[(m_first + m_count) % m_entries.size()] = {
+      .offset = offset,
+      .size = size,
+      .key = key,
+  };
+
+  m_count++;
+  m_used += size;
+  m_since_key = key ? 0 : m_since_key + 1;
+}
+
+auto rewind_buffer::load(const entry& value) -> void {
+  auto first = std::min(value.size, m_data.size() - value.offset);
+
+  std::copy_n(m_data.begin() + value.offset, first, m_scratch.begin());
+  std::copy_n(m_data.begin(), value.size - first, m_scratch.begin() + first);
+}
+
+auto rewind_buffer::apply(std::size_t size) -> void {
+  for (auto pos = 0UZ, idx = 0UZ; pos < size;) {
+    auto header = m_scratch[pos++];
+
+    idx += header >> 32;
+
+    for (auto count = header & 0xffffffff; count > 0; count--) {
+      m_last[idx++] ^= m_scratch[pos++];
+    }
+  }
+}
+
+auto rewind_buffer::at(std::size_t idx) const -> const entry& {
+  return m_entries[(m_first + idx) % m_entries.size()];
+}
+}  // namespace chip8
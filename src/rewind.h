@@ -0,0 +1,94 @@
+#ifndef HK_CHIP8_REWIND_H
+#define HK_CHIP8_REWIND_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "common.h"
+#include "machine_state.h"
+
+namespace chip8 {
+// Recent machine states for stepping backwards, within a fixed number of
+// frames and bytes. Every interval frames a whole state is kept, the frames
+// in between only keep what changed from the one before: the XOR of the two,
+// run length encoded as zero and literal runs of 64 bit words. The oldest
+// frames go first when either limit is reached.
+class rewind_buffer {
+  // Holds a std::uint64_t, so it's made of whole words
+  static_assert(sizeof(machine_state) % sizeof(std::uint64_t) == 0);
+
+ public:
+  // Words the state is compared in
+  static constexpr auto WORDS = sizeof(machine_state) / sizeof(std::uint64_t);
+
+  explicit rewind_buffer(std::size_t frames, std::size_t bytes,
+                         std::size_t interval = 60);
+
+  // Keep state as the newest frame
+  auto push(const machine_state& state) -> void;
+
+  // Drop the newest frame and return the one before it, if any is left
+  [[nodiscard]] auto step_back() -> std::optional<machine_state>;
+
+  auto clear() -> void;
+
+  [[nodiscard]] auto frames() const -> std::size_t;
+  [[nodiscard]] auto bytes() const -> std::size_t;
+
+ private:
+  using words = std::array<std::uint64_t, WORDS>;
+
+  // Words skipped at once while nothing changed
+  static constexpr auto BLOCK = 8UZ;
+
+  // Offset and size in words
+  struct entry {
+    std::size_t offset;
+    std::size_t size;
+    bool key;
+  };
+
+  // Word idx of state XOR the same word of m_last
+  [[nodiscard]] auto delta(std::span<const std::byte> state,
+                           std::size_t idx) const -> std::uint64_t;
+  [[nodiscard]] auto unchanged(std::span<const std::byte> state,
+                               std::size_t idx) const -> bool;
+
+  // Drop the oldest frames until size more words fit
+  auto make_room(std::size_t size) -> void;
+  auto drop_oldest() -> void;
+
+  // Entry data is stored back to back around m_data
+  auto store(const std::uint64_t* data, std::size_t size, bool key) -> void;
+  auto load(const entry& value) -> void;
+
+  // XOR the delta loaded into m_scratch into m_last
+  auto apply(std::size_t size) -> void;
+
+  // Oldest first
+  [[nodiscard]] auto at(std::size_t idx) const -> const entry&;
+
+  std::size_t m_interval;
+
+  // Ring of entries, oldest first, the oldest always being a whole state
+  std::vector<entry> m_entries;
+  std::size_t m_first{};
+  std::size_t m_count{};
+  std::size_t m_since_key{};
+
+  // Ring of entry data, m_start is where the oldest entry's data begins
+  std::vector<std::uint64_t> m_data;
+  std::size_t m_start{};
+  std::size_t m_used{};
+
+  // Newest state, and room to encode or decode one entry
+  words m_last{};
+  std::vector<std::uint64_t> m_scratch;
+};
+}  // namespace chip8
+
+#endif
@@ -0,0 +1,37 @@
+#include "rom.h"
+
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <optional>
+#include <vector>
+
+#include "common.h"
+#include "helpers.h"
+
+namespace chip8 {
+auto read_rom(const std::filesystem::path& file)
+    -> std::optional<std::vector<byte>> {
+  if (not std::filesystem::is_regular_file(file)) {
+    return std::nullopt;
+  }
+
+  std::ifstream rom{file, std::ios::binary | std::ios::ate};
+
+  auto end = rom.tellg();
+  if (not rom or end < 0) {
+    return std::nullopt;
+  }
+
+  auto data = std::vector<byte>(as<std::size_t>(end));
+
+  rom.seekg(0, std::ios::beg);
+  rom.read(reinterpret_cast<char*>(data.data()), end);
+
+  if (not rom) {
+    return std::nullopt;
+  }
+
+  return data;
+}
+}  // namespace chip8
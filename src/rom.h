@@ -0,0 +1,16 @@
+#ifndef HK_CHIP8_ROM_H
+#define HK_CHIP8_ROM_H
+
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+#include "common.h"
+
+namespace chip8 {
+// Whole contents of a ROM file, nothing if it isn't a file that reads
+[[nodiscard]] auto read_rom(const std::filesystem::path& file)
+    -> std::optional<std::vector<byte>>;
+}  // namespace chip8
+
+#endif
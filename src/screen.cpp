@@ -1,125 +1,70 @@
 #include "screen.h"
 
-#include <raylib.h>
-
 #include <cstddef>
+#include <cstdint>
 
 #include "common.h"
 
 namespace chip8 {
 auto screen::clear() -> void {
-  for (auto& row : m_screen) {
-    row.reset();
-  }
-}
-
-auto screen::full() -> void {
-  for (auto& row : m_screen) {
-    row.set();
-  }
-}
-
-auto screen::draw_screen() const -> void {
-  int pos_x = 0;
-  int pos_y = 0;
+  m_screen.fill(0);
 
-  BeginDrawing();
-
-  ClearBackground(BG_COLOR);
-
-  for (const auto& row : m_screen) {
-    pos_x = 0;
-
-    for (auto col = 0; col < row.size(); col++) {
-      if (row[col]) {
-        DrawRectangle(pos_x, pos_y, PIXEL, PIXEL, FG_COLOR);
-      }
-      pos_x += PIXEL;
-    }
-    pos_y += PIXEL;
-  }
-
-  EndDrawing();
+  m_dirty.set();
 }
 
-auto screen::operator[](std::size_t idx_x, std::size_t idx_y) const -> bool {
-  return m_screen.at(idx_y).test(idx_x);
-}
+auto screen::full() -> void {
+  m_screen.fill(~0ULL);
 
-auto screen::operator[](std::size_t idx_x, std::size_t idx_y) -> reference {
-  return m_screen.at(idx_y)[idx_x];
+  m_dirty.set();
 }
 
-auto screen::begin() -> iterator { return m_screen.begin(); }
+auto screen::draw(std::size_t idx_y, row_type sprite) -> bool {
+  if (sprite == 0) {
+    return false;
+  }
 
-auto screen::end() -> iterator { return m_screen.end(); }
+  auto& row = m_screen.at(idx_y);
+  auto collision = (row & sprite) != 0;
 
-auto screen::pixel_iter(std::size_t idx_x, std::size_t idx_y)
-    -> pixel_iterator {
-  return pixel_iterator(*this, idx_x, idx_y);
-}
+  row ^= sprite;
+  m_dirty.set(idx_y);
 
-pixel_iterator::pixel_iterator(screen& p_screen, std::size_t pix_x,
-                               std::size_t pix_y)
-    : m_screen(&p_screen),
-      m_idx_x(pix_x % WIDTH),
-      m_idx_y(pix_y % HEIGHT),
-      m_orig_x(m_idx_x),
-      m_orig_y(m_idx_y) {}
-
-auto pixel_iterator::operator++() -> pixel_iterator& {
-  inc_idx();
-  return *this;
+  return collision;
 }
 
-auto pixel_iterator::operator++(int) -> pixel_iterator {
-  auto old = *this;
-  operator++();
-  return old;
-}
+auto screen::dirty() const -> bool { return m_dirty.any(); }
 
-auto pixel_iterator::operator--() -> pixel_iterator& {
-  dec_idx();
-  return *this;
+auto screen::dirty_rows() const -> const std::bitset<HEIGHT>& {
+  return m_dirty;
 }
 
-auto pixel_iterator::operator--(int) -> pixel_iterator {
-  auto old = *this;
-  operator--();
-  return old;
-}
+auto screen::mark_clean() -> void { m_dirty.reset(); }
 
-auto pixel_iterator::operator*() -> screen::reference {
-  auto& screen_v = *(this->m_screen);
-  return screen_v[m_idx_x % WIDTH, m_idx_y % HEIGHT];
-}
+auto screen::mark_dirty() -> void { m_dirty.set(); }
 
-auto pixel_iterator::operator*() const -> bool {
-  const auto& screen_v = *(this->m_screen);
-  return screen_v[m_idx_x, m_idx_y];
-}
+auto screen::hash() const -> std::uint64_t {
+  auto result = 0xcbf29ce484222325ULL;
 
-auto pixel_iterator::inc_idx() -> void {
-  m_idx_x++;
-  if ((m_idx_x - m_orig_x) < 8) {
-    return;
+  for (const auto& row : m_screen) {
+    for (auto idx = 0; idx < 8; idx++) {
+      result ^= (row >> (idx * 8)) & 0xff;
+      result *= 0x100000001b3ULL;
+    }
   }
 
-  m_idx_x = m_orig_x;
-  m_idx_y++;
+  return result;
 }
 
-auto pixel_iterator::dec_idx() -> void {
-  if (m_idx_x == m_orig_x) {
-    m_idx_y--;
-    m_idx_x = m_orig_x + 8 - 1;
-    return;
-  }
+auto screen::operator[](std::size_t idx_x, std::size_t idx_y) const -> bool {
+  return ((m_screen.at(idx_y) >> (idx_x % WIDTH)) & 1) != 0;
+}
 
-  m_idx_x--;
+auto screen::operator[](std::size_t idx_x, std::size_t idx_y) -> reference {
+  m_dirty.set(idx_y);
+  return reference(m_screen.at(idx_y), 1ULL << (idx_x % WIDTH));
 }
 
-auto pixel_iterator::origin() const -> position { return {m_orig_x, m_orig_y}; }
+auto screen::begin() const -> const_iterator { return m_screen.begin(); }
 
-auto pixel_iterator::index() const -> position { return {m_idx_x, m_idx_y}; }
+auto screen::end() const -> const_iterator { return m_screen.end(); }
 }  // namespace chip8
@@ -1,19 +1,52 @@
 #ifndef HK_CHIP8_SCREEN_H
 #define HK_CHIP8_SCREEN_H
 
+#include <array>
+#include <bit>
 #include <bitset>
+#include <cstddef>
+#include <cstdint>
 
+#include "bit.h"
 #include "common.h"
+#include "helpers.h"
 
 namespace chip8 {
-class pixel_iterator;
+// Sprite byte as a screen row at idx_x, the leftmost sprite pixel at bit
+// idx_x. Wrapped sprites carry over to the left edge, clipped ones drop off
+// the right.
+constexpr auto sprite_row(byte data, std::size_t idx_x, bool clip)
+    -> std::uint64_t {
+  auto row = as<std::uint64_t>(mirror(data));
+
+  return clip ? row << idx_x : std::rotl(row, as<int>(idx_x));
+}
 
 class screen {
  public:
-  using row_type = std::bitset<WIDTH>;
+  // Pixel x of a row is bit x
+  using row_type = std::uint64_t;
   using inner_type = std::array<row_type, HEIGHT>;
-  using iterator = inner_type::iterator;
-  using reference = row_type::reference;
+  using const_iterator = inner_type::const_iterator;
+
+  // Writable pixel, a bit in one row
+  class reference {
+   public:
+    explicit reference(row_type& row, row_type mask)
+        : m_row(&row), m_mask(mask) {}
+
+    operator bool() const { return (*m_row & m_mask) != 0; }
+    auto operator~() const -> bool { return not as<bool>(*this); }
+
+    auto operator=(bool value) -> reference& {
+      *m_row = value ? *m_row | m_mask : *m_row & ~m_mask;
+      return *this;
+    }
+
+   private:
+    row_type* m_row;
+    row_type m_mask;
+  };
 
   explicit screen() = default;
   ~screen() = default;
@@ -27,51 +60,29 @@ class screen {
   auto clear() -> void;
   auto full() -> void;
 
-  auto draw_screen() const -> void;
+  // XOR sprite into row idx_y, true if that turned any pixel off
+  auto draw(std::size_t idx_y, row_type sprite) -> bool;
 
-  // Index using (x, y)
+  // FNV-1a over the rows, top to bottom
+  [[nodiscard]] auto hash() const -> std::uint64_t;
+
+  // Rows changed since the last mark_clean(), a new screen is all dirty
+  [[nodiscard]] auto dirty() const -> bool;
+  [[nodiscard]] auto dirty_rows() const -> const std::bitset<HEIGHT>&;
+  auto mark_clean() -> void;
+  auto mark_dirty() -> void;
+
+  // Index using (x, y), writable access marks the row dirty
   auto operator[](std::size_t idx_x, std::size_t idx_y) const -> bool;
   auto operator[](std::size_t idx_x, std::size_t idx_y) -> reference;
 
-  auto begin() -> iterator;
-  auto end() -> iterator;
-
-  auto pixel_iter(std::size_t idx_x, std::size_t idx_y) -> pixel_iterator;
+  // Read only, writes go through operator[], draw(), clear() and full()
+  auto begin() const -> const_iterator;
+  auto end() const -> const_iterator;
 
  private:
   inner_type m_screen{};
-  bool m_is_init_raylib{false};
-};
-
-class pixel_iterator {
- public:
-  using position = std::tuple<std::size_t, std::size_t>;
-
-  explicit pixel_iterator(screen& p_screen, std::size_t pix_x = 0,
-                          std::size_t pix_y = 0);
-
-  auto operator++() -> pixel_iterator&;
-  auto operator++(int) -> pixel_iterator;
-
-  auto operator--() -> pixel_iterator&;
-  auto operator--(int) -> pixel_iterator;
-
-  auto operator*() -> screen::reference;
-  auto operator*() const -> bool;
-
-  auto origin() const -> position;
-  auto index() const -> position;
-
- private:
-  auto inc_idx() -> void;
-  auto dec_idx() -> void;
-
-  screen* m_screen;
-  std::size_t m_idx_x;
-  std::size_t m_idx_y;
-
-  std::size_t m_orig_x;
-  std::size_t m_orig_y;
+  std::bitset<HEIGHT> m_dirty{~0ULL};
 };
 }  // namespace chip8
 
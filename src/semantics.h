@@ -0,0 +1,136 @@
+#ifndef HK_CHIP8_SEMANTICS_H
+#define HK_CHIP8_SEMANTICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+#include "common.h"
+#include "helpers.h"
+#include "keyboard.h"
+#include "quirks.h"
+#include "screen.h"
+
+// Opcode handlers shared by chip8 and the one lane at a time path of batch,
+// so their quirks live in one place. They run on a machine view M with
+//   v(regs) -> byte&, i() -> word&, pc() -> word&
+//   read(word) -> byte, write(word, byte)
+//   draw(std::size_t row, std::uint64_t sprite) -> bool, true on collision
+//   keyboard() -> const keyboard&, key_wait() -> std::optional<keys>&
+namespace chip8::semantics {
+// SYS runs machine code on the original hardware, none of which exists here,
+// so execution carries on with the next instruction
+template <typename M>
+auto sys(M& /*machine*/, word /*addr*/) -> void {}
+
+template <quirks Q, typename M>
+auto jp_v0(M& machine, word addr) -> void {
+  if constexpr (Q.jump_vx) {
+    machine.pc() = address(addr + machine.v(as<regs>(addr >> 8)));
+  } else {
+    machine.pc() = address(addr + machine.v(regs::V0));
+  }
+}
+
+template <quirks Q, typename M>
+auto drw(M& machine, regs reg_x, regs reg_y, byte count) -> void {
+  // The starting position wraps, with the clip quirk the rest doesn't
+  auto pos_x = machine.v(reg_x) % WIDTH;
+  auto pos_y = machine.v(reg_y) % HEIGHT;
+  auto addr = machine.i();
+  auto collision = false;
+
+  for (auto row = 0Z; row < count; row++) {
+    auto pix_y = pos_y + row;
+
+    if (Q.clip and pix_y >= HEIGHT) {
+      break;
+    }
+
+    auto sprite = sprite_row(machine.read(addr++), pos_x, Q.clip);
+    collision |= machine.draw(pix_y % HEIGHT, sprite);
+  }
+
+  machine.v(regs::VF) = collision ? 0x01 : 0x00;
+}
+
+template <typename M>
+auto bcd(M& machine, regs reg) -> void {
+  auto value = machine.v(reg);
+  auto addr = machine.i();
+
+  machine.write(addr, as<byte>(value / 100));
+  machine.write(as<word>(addr + 1), as<byte>((value / 10) % 10));
+  machine.write(as<word>(addr + 2), as<byte>(value % 10));
+}
+
+template <quirks Q, typename M>
+auto st_regs(M& machine, regs reg) -> void {
+  auto addr = machine.i();
+
+  for (auto idx = 0; idx <= std::to_underlying(reg); idx++) {
+    machine.write(addr++, machine.v(as<regs>(idx)));
+  }
+
+  if constexpr (Q.increment_i) {
+    machine.i() = addr;
+  }
+}
+
+template <quirks Q, typename M>
+auto ld_regs(M& machine, regs reg) -> void {
+  auto addr = machine.i();
+
+  for (auto idx = 0; idx <= std::to_underlying(reg); idx++) {
+    machine.v(as<regs>(idx)) = machine.read(addr++);
+  }
+
+  if constexpr (Q.increment_i) {
+    machine.i() = addr;
+  }
+}
+
+// Values past F name no key, so they are never down
+template <typename M>
+auto pressed(M& machine, regs reg) -> bool {
+  auto value = machine.v(reg);
+  return value < 0x10 and machine.keyboard().is_pressed(as<keys>(value));
+}
+
+template <typename M>
+auto skp(M& machine, regs reg) -> void {
+  if (pressed(machine, reg)) {
+    machine.pc() += 2;
+  }
+}
+
+template <typename M>
+auto sknp(M& machine, regs reg) -> void {
+  if (not pressed(machine, reg)) {
+    machine.pc() += 2;
+  }
+}
+
+// Wait for a key to be pressed and then released. True while still waiting,
+// with PC back on the instruction so it runs again.
+template <typename M>
+auto ld_key(M& machine, regs reg) -> bool {
+  auto& wait = machine.key_wait();
+
+  if (not wait or machine.keyboard().is_pressed(*wait)) {
+    if (not wait) {
+      wait = machine.keyboard().key();
+    }
+
+    machine.pc() = address(machine.pc() - 2);
+    return true;
+  }
+
+  machine.v(reg) = as<byte>(*wait);
+  wait.reset();
+  return false;
+}
+}  // namespace chip8::semantics
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef HK_CHIP8_SPSC_QUEUE_H
+#define HK_CHIP8_SPSC_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+
+namespace chip8 {
+// Lock free bounded queue from one producer thread to one consumer thread
+template <typename T, std::size_t Size>
+class spsc_queue {
+  static_assert((Size & (Size - 1)) == 0, "Size must be a power of two");
+
+ public:
+  // Producer side, false when full
+  auto push(const T& value) -> bool {
+    auto tail = m_tail.load(std::memory_order_relaxed);
+
+    if (tail - m_head.load(std::memory_order_acquire) == Size) {
+      return false;
+    }
+
+    m_items[tail % Size] = value;
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side
+  auto pop() -> std::optional<T> {
+    auto head = m_head.load(std::memory_order_relaxed);
+
+    if (head == m_tail.load(std::memory_order_acquire)) {
+      return std::nullopt;
+    }
+
+    auto value = m_items[head % Size];
+    m_head.store(head + 1, std::memory_order_release);
+    return value;
+  }
+
+ private:
+  std::array<T, Size> m_items{};
+  std::atomic<std::size_t> m_head{};
+  std::atomic<std::size_t> m_tail{};
+};
+}  // namespace chip8
+
+#endif
@@ -0,0 +1,99 @@
+#include "terminal_frontend.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <ostream>
+#include <string_view>
+
+#include "common.h"
+#include "helpers.h"
+#include "screen.h"
+
+namespace chip8 {
+namespace {
+constexpr auto CELL_ROWS = HEIGHT / 2;
+
+// Indexed by top pixel | bottom pixel << 1
+constexpr auto GLYPHS = std::array<std::string_view, 4>{
+    " ",
+    "▀",
+    "▄",
+    "█",
+};
+}  // namespace
+
+terminal_frontend::terminal_frontend(std::ostream& out) : m_out(&out) {
+  // Room for every cell and a cursor move for each of them
+  m_buffer.reserve(WIDTH * CELL_ROWS * 16);
+}
+
+terminal_frontend::~terminal_frontend() {
+  if (m_drawn) {
+    *m_out << fmt::format("\x1b[{};1H\x1b[?25h", CELL_ROWS + 1);
+    m_out->flush();
+  }
+}
+
+auto terminal_frontend::present(const screen& value) -> void {
+  auto rows = std::array<std::uint64_t, HEIGHT>{};
+  std::ranges::copy(value, rows.begin());
+
+  m_buffer.clear();
+  auto out = std::back_inserter(m_buffer);
+
+  if (not m_drawn) {
+    // Hide the cursor and start from a blank terminal
+    fmt::format_to(out, "\x1b[?25l\x1b[2J");
+  }
+
+  for (auto cell_row = 0Z; cell_row < CELL_ROWS; cell_row++) {
+    auto top = rows.at(cell_row * 2);
+    auto bottom = rows.at((cell_row * 2) + 1);
+
+    auto changed = ~std::uint64_t{};
+
+    if (m_drawn) {
+      changed = (top ^ m_shown.at(cell_row * 2)) |
+                (bottom ^ m_shown.at((cell_row * 2) + 1));
+    }
+
+    // Column the terminal cursor is at, writing a cell moves it right
+    auto cursor = WIDTH;
+
+    for (auto col = 0Z; changed != 0 and col < WIDTH; col++) {
+      if (((changed >> col) & 1) == 0) {
+        continue;
+      }
+
+      if (col != cursor) {
+        fmt::format_to(out, "\x1b[{};{}H", cell_row + 1, col + 1);
+      }
+
+      auto glyph = ((top >> col) & 1) | (((bottom >> col) & 1) << 1);
+      fmt::format_to(out, "{}", GLYPHS.at(glyph));
+
+      cursor = col + 1;
+    }
+  }
+
+  m_shown = rows;
+  m_drawn = true;
+
+  if (not m_buffer.empty()) {
+    m_out->write(m_buffer.data(), as<std::streamsize>(m_buffer.size()));
+    m_out->flush();
+  }
+
+  m_pacer.wait();
+}
+
+auto terminal_frontend::throttled() const -> bool { return m_pacer.enabled(); }
+
+auto terminal_frontend::set_throttle(bool value) -> void {
+  m_pacer.set_enabled(value);
+}
+}  // namespace chip8
@@ -0,0 +1,51 @@
+#ifndef HK_CHIP8_TERMINAL_FRONTEND_H
+#define HK_CHIP8_TERMINAL_FRONTEND_H
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "common.h"
+#include "frontend.h"
+#include "pacer.h"
+#include "screen.h"
+
+namespace chip8 {
+// Display on an ANSI terminal, for hosts without a window system. Each cell
+// holds two pixel rows as a half block, and a frame only rewrites the cells
+// that changed, in one write.
+class terminal_frontend final : public display {
+ public:
+  explicit terminal_frontend(std::ostream& out);
+
+  // Leaves the cursor below the screen
+  ~terminal_frontend() override;
+
+  terminal_frontend(const terminal_frontend&) = delete;
+  terminal_frontend(terminal_frontend&&) = delete;
+
+  auto operator=(const terminal_frontend&) -> terminal_frontend& = delete;
+  auto operator=(terminal_frontend&&) -> terminal_frontend& = delete;
+
+  auto present(const screen& value) -> void override;
+  [[nodiscard]] auto closed() -> bool override { return false; }
+
+  // Hold presented frames to 60 Hz, on by default
+  [[nodiscard]] auto throttled() const -> bool;
+  auto set_throttle(bool value) -> void;
+
+ private:
+  std::ostream* m_out;
+  pacer m_pacer;
+
+  // Rows on the terminal, nothing is drawn until the first frame
+  std::array<std::uint64_t, HEIGHT> m_shown{};
+  bool m_drawn{};
+
+  // Reused between frames, so drawing doesn't allocate
+  std::string m_buffer;
+};
+}  // namespace chip8
+
+#endif
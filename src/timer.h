@@ -1,34 +1,65 @@
 #ifndef HK_CHIP8_TIMER_H
 #define HK_CHIP8_TIMER_H
 
-#include <chrono>
-#include <concepts>
-#include <functional>
+#include <cstdint>
+#include <limits>
 
 #include "common.h"
 
 namespace chip8 {
-using namespace std::literals;
-
+// Virtual clock behind the delay and sound timers. It only moves with
+// emulated work, never with the host clock, so headless runs are
+// deterministic. Ticks once per frame by default, or once every period
+// instructions.
 class timer {
-  static constexpr auto DELAY = 16ms;
-
  public:
-  template <std::invocable Callback>
-  timer(Callback callback)
-      : m_callback(callback), m_last_tick(std::chrono::steady_clock::now()) {}
-
-  auto tick() -> void {
-    if (auto now = std::chrono::steady_clock::now();
-        (now - m_last_tick) >= DELAY) {
-      m_last_tick = now;
-      m_callback();
+  static constexpr auto PER_FRAME = std::uint64_t{0};
+
+  [[nodiscard]] auto period() const -> std::uint64_t { return m_period; }
+
+  auto set_period(std::uint64_t instructions) -> void {
+    m_period = instructions;
+    m_elapsed = 0;
+  }
+
+  [[nodiscard]] auto per_frame() const -> bool {
+    return m_period == PER_FRAME;
+  }
+
+  // Instructions left before the next tick, unbounded when ticking per frame
+  [[nodiscard]] auto until_tick() const -> std::uint64_t {
+    if (per_frame()) {
+      return std::numeric_limits<std::uint64_t>::max();
+    }
+
+    return m_period - m_elapsed;
+  }
+
+  // Count executed instructions, at most until_tick() of them. True when
+  // that reaches the next tick.
+  auto advance(std::uint64_t count) -> bool {
+    if (per_frame()) {
+      return false;
     }
+
+    m_elapsed += count;
+
+    if (m_elapsed < m_period) {
+      return false;
+    }
+
+    m_elapsed = 0;
+    return true;
   }
 
+  auto tick() -> void { m_ticks++; }
+
+  [[nodiscard]] auto ticks() const -> std::uint64_t { return m_ticks; }
+
  private:
-  std::chrono::steady_clock::time_point m_last_tick;
-  std::function<void(void)> m_callback;
+  std::uint64_t m_period{PER_FRAME};
+  std::uint64_t m_elapsed{};
+  std::uint64_t m_ticks{};
 };
 }  // namespace chip8
 
@@ -0,0 +1,46 @@
+#ifndef HK_CHIP8_TRIPLE_BUFFER_H
+#define HK_CHIP8_TRIPLE_BUFFER_H
+
+#include <array>
+#include <atomic>
+
+namespace chip8 {
+// Lock free hand over of the latest value from one producer thread to one
+// consumer thread. Neither side ever waits on the other, the consumer skips
+// whatever it was too slow to see.
+template <typename T>
+class triple_buffer {
+ public:
+  // Producer side, fill back() then publish it
+  auto back() -> T& { return m_slots.at(m_back); }
+
+  auto publish() -> void {
+    m_back = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel) &
+             INDEX;
+  }
+
+  // Consumer side, true when front() changed to a newer value
+  auto update() -> bool {
+    if ((m_middle.load(std::memory_order_relaxed) & FRESH) == 0) {
+      return false;
+    }
+
+    m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX;
+    return true;
+  }
+
+  [[nodiscard]] auto front() const -> const T& { return m_slots.at(m_front); }
+
+ private:
+  // The middle slot index, flagged while the consumer hasn't taken it
+  static constexpr auto INDEX = 0x3U;
+  static constexpr auto FRESH = 0x4U;
+
+  std::array<T, 3> m_slots;
+  unsigned m_back{0};
+  unsigned m_front{1};
+  std::atomic<unsigned> m_middle{2};
+};
+}  // namespace chip8
+
+#endif
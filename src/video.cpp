@@ -0,0 +1,142 @@
+#include "video.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+
+#include "bit.h"
+#include "common.h"
+#include "helpers.h"
+#include "screen.h"
+
+namespace chip8 {
+namespace {
+// Studio swing luma for lit and dark pixels
+constexpr auto LUMA_ON = byte{235};
+constexpr auto LUMA_OFF = byte{16};
+}  // namespace
+
+video_writer::video_writer(std::ostream& out, video_format format)
+    : m_out(&out), m_format(format), m_thread([this] { run(); }) {
+  if (m_format == video_format::y4m) {
+    *m_out << "YUV4MPEG2 W" << WIDTH << " H" << HEIGHT
+           << " F60:1 Ip A1:1 Cmono\n";
+  }
+}
+
+video_writer::~video_writer() {
+  {
+    auto lock = std::scoped_lock{m_lock};
+    m_done = true;
+  }
+
+  m_queued.notify_one();
+  m_thread.join();
+
+  m_out->flush();
+}
+
+auto video_writer::present(const screen& value) -> void {
+  auto pixels = pack(value);
+  auto repeat = m_frames != 0 and pixels == m_last;
+
+  m_frames++;
+
+  if (repeat) {
+    m_repeats++;
+  } else {
+    m_last = pixels;
+  }
+
+  auto lock = std::unique_lock{m_lock};
+
+  m_written.wait(lock, [this] { return m_tail - m_head < POOL_SIZE; });
+
+  auto& slot = m_pool.at(m_tail % POOL_SIZE);
+  slot.repeat = repeat;
+
+  if (not repeat) {
+    slot.pixels = pixels;
+  }
+
+  m_tail++;
+
+  lock.unlock();
+  m_queued.notify_one();
+}
+
+auto video_writer::frames() const -> std::uint64_t { return m_frames; }
+
+auto video_writer::repeats() const -> std::uint64_t { return m_repeats; }
+
+auto video_writer::pack(const screen& value) -> packed {
+  auto result = packed{};
+  auto out = result.begin();
+
+  for (auto row : value) {
+    for (auto idx = 0Z; idx < ROW_SIZE; idx++) {
+      *out++ = mirror(as<byte>(row >> (idx * 8)));
+    }
+  }
+
+  return result;
+}
+
+auto video_writer::run() -> void {
+  auto lock = std::unique_lock{m_lock};
+
+  while (true) {
+    m_queued.wait(lock, [this] { return m_done or m_head != m_tail; });
+
+    if (m_head == m_tail) {
+      return;
+    }
+
+    // The slot stays ours until m_head moves past it
+    auto& slot = m_pool.at(m_head % POOL_SIZE);
+
+    lock.unlock();
+    write(slot);
+    lock.lock();
+
+    m_head++;
+    m_written.notify_one();
+  }
+}
+
+auto video_writer::write(const frame& value) -> void {
+  if (not value.repeat) {
+    m_previous = value.pixels;
+  }
+
+  auto* data = reinterpret_cast<const char*>(m_previous.data());
+
+  switch (m_format) {
+    case video_format::raw:
+      if (value.repeat) {
+        m_out->put('R');
+      } else {
+        m_out->put('F');
+        m_out->write(data, FRAME_SIZE);
+      }
+      break;
+
+    case video_format::pbm:
+      *m_out << "P4\n" << WIDTH << ' ' << HEIGHT << '\n';
+      m_out->write(data, FRAME_SIZE);
+      break;
+
+    case video_format::y4m:
+      *m_out << "FRAME\n";
+
+      for (auto packed_byte : m_previous) {
+        for (auto bit = 7; bit >= 0; bit--) {
+          m_out->put(as<char>(((packed_byte >> bit) & 1) != 0 ? LUMA_ON
+                                                               : LUMA_OFF));
+        }
+      }
+      break;
+  }
+}
+}  // namespace chip8
@@ -0,0 +1,92 @@
+#ifndef HK_CHIP8_VIDEO_H
+#define HK_CHIP8_VIDEO_H
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+#include "common.h"
+#include "frontend.h"
+#include "screen.h"
+
+namespace chip8 {
+enum class video_format : byte {
+  // A tag byte per frame, 'F' and the packed frame or 'R' for a repeat
+  raw,
+  // Concatenated binary PBM images, lit pixels are black
+  pbm,
+  // YUV4MPEG2 with a mono 60 fps luma plane, for piping into an encoder
+  y4m,
+};
+
+// Display writing every presented frame to a stream. Frames are packed one
+// bit per pixel into a preallocated pool and written by a background thread,
+// so emulation only waits when the stream falls a whole pool behind.
+class video_writer final : public display {
+ public:
+  // Packed rows, the leftmost pixel in the most significant bit
+  static constexpr auto ROW_SIZE = WIDTH / 8;
+  static constexpr auto FRAME_SIZE = ROW_SIZE * HEIGHT;
+  static constexpr auto POOL_SIZE = 64Z;
+
+  using packed = std::array<byte, FRAME_SIZE>;
+
+  explicit video_writer(std::ostream& out, video_format format);
+
+  // Writes whatever is still queued
+  ~video_writer() override;
+
+  video_writer(const video_writer&) = delete;
+  video_writer(video_writer&&) = delete;
+
+  auto operator=(const video_writer&) -> video_writer& = delete;
+  auto operator=(video_writer&&) -> video_writer& = delete;
+
+  auto present(const screen& value) -> void override;
+  [[nodiscard]] auto closed() -> bool override { return false; }
+
+  // Frames presented so far and how many of them repeated the one before
+  [[nodiscard]] auto frames() const -> std::uint64_t;
+  [[nodiscard]] auto repeats() const -> std::uint64_t;
+
+  [[nodiscard]] static auto pack(const screen& value) -> packed;
+
+ private:
+  struct frame {
+    packed pixels;
+    bool repeat;
+  };
+
+  auto run() -> void;
+  auto write(const frame& value) -> void;
+
+  std::ostream* m_out;
+  video_format m_format;
+
+  // Emulation thread
+  packed m_last{};
+  std::uint64_t m_frames{};
+  std::uint64_t m_repeats{};
+
+  // Frames between m_head and m_tail are queued for the writer thread
+  std::array<frame, POOL_SIZE> m_pool{};
+  std::size_t m_head{};
+  std::size_t m_tail{};
+  bool m_done{};
+  std::mutex m_lock;
+  std::condition_variable m_queued;
+  std::condition_variable m_written;
+
+  // Writer thread, repeats are written out in full except in raw streams
+  packed m_previous{};
+
+  // Last, so it stops before anything it uses goes away
+  std::jthread m_thread;
+};
+}  // namespace chip8
+
+#endif
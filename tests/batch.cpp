@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "batch.h"
+#include "chip8.h"
+#include "common.h"
+#include "fixture.h"
+#include "helpers.h"
+#include "instructions.h"
+#include "quirks.h"
+
+namespace op = chip8::opcode;
+using chip8::regs;
+
+namespace {
+// Each lane starts from a different V0 and V1, so skips and the call split
+// the lanes up and bring them back together
+auto make_rom(std::size_t lane) -> std::vector<chip8::byte> {
+  return fixture::to_rom({
+      op::LD(regs::V0, as<chip8::byte>(lane * 7)),  // 200
+      op::LD(regs::V1, as<chip8::byte>(lane % 3)),  // 202
+      op::ADD(regs::V0, regs::V1),                  // 204
+      op::SE(regs::V1, 0x01),                       // 206
+      op::CALL(0x0218),                             // 208
+      op::SUB(regs::V2, regs::V0),                  // 20a
+      op::SHL(regs::V3, regs::V2),                  // 20c
+      op::LD_F(regs::V3),                           // 20e
+      op::DRW(regs::V0, regs::V2, 5),               // 210
+      op::SNE(regs::V4, 0x20),                      // 212
+      op::LD(regs::V4, 0x00),                       // 214
+      op::JP(0x0204),                               // 216
+      op::OR(regs::V5, regs::V0),                   // 218
+      op::ADD(regs::V4, 0x01),                      // 21a
+      op::LD_I(0x0300),                             // 21c
+      op::ADD_I(regs::V4),                          // 21e
+      op::LD_B(regs::V0),                           // 220
+      op::LD_I(regs::V2),                           // 222
+      op::RND(regs::V6, 0xf7),                      // 224
+      op::RET(),                                    // 226
+  });
+}
+
+// Every ALU opcode, with VF and equal values as operands too. RND gives the
+// lanes fresh values on every pass, SYS runs once on the way in.
+const auto alu_rom = fixture::to_rom({
+    op::SYS(0x0300),               // 200
+    op::RND(regs::V0, 0xff),       // 202
+    op::RND(regs::V1, 0xff),       // 204
+    op::RND(regs::VF, 0xff),       // 206
+    op::ADD(regs::V0, regs::V1),   // 208
+    op::SUB(regs::V2, regs::V0),   // 20a
+    op::SUBN(regs::V3, regs::V1),  // 20c
+    op::SHR(regs::V4, regs::V2),   // 20e
+    op::SHL(regs::V5, regs::V3),   // 210
+    op::OR(regs::V6, regs::V4),    // 212
+    op::AND(regs::V7, regs::V5),   // 214
+    op::XOR(regs::V8, regs::V6),   // 216
+    op::ADD(regs::V9, 0x35),       // 218
+    op::LD(regs::VA, regs::V9),    // 21a
+    op::SUB(regs::VA, regs::V9),   // 21c
+    op::LD(regs::VB, regs::V2),    // 21e
+    op::SUBN(regs::VB, regs::V2),  // 220
+    op::ADD(regs::VF, regs::V0),   // 222
+    op::SUB(regs::VC, regs::VF),   // 224
+    op::SUBN(regs::VF, regs::V7),  // 226
+    op::SHR(regs::VF, regs::V6),   // 228
+    op::SHL(regs::VD, regs::VF),   // 22a
+    op::OR(regs::VF, regs::V8),    // 22c
+    op::AND(regs::VE, regs::VF),   // 22e
+    op::XOR(regs::VF, regs::VB),   // 230
+    op::SHL(regs::V1, regs::V1),   // 232
+    op::SUB(regs::V1, regs::V1),   // 234
+    op::RND(regs::V0, 0xff),       // 236
+    op::RND(regs::V1, 0xff),       // 238
+    op::RND(regs::V2, 0xff),       // 23a
+    op::RND(regs::V3, 0xff),       // 23c
+    op::JP(0x0208),                // 23e
+});
+
+template <std::size_t Lanes, chip8::quirks Q>
+auto expect_lockstep(chip8::profile value) -> void {
+  constexpr auto STEPS = 2'000UZ;
+
+  auto lanes = chip8::batch<Lanes, Q>{};
+
+  for (auto lane = 0UZ; lane < Lanes; lane++) {
+    lanes.load_rom(lane, make_rom(lane));
+    lanes.seed(lane, lane);
+  }
+
+  lanes.exec_n(STEPS);
+
+  for (auto lane = 0UZ; lane < Lanes; lane++) {
+    auto emulator = std::make_unique<chip8::chip8>();
+    emulator->set_profile(value);
+    emulator->seed(lane);
+    emulator->load_rom(make_rom(lane));
+    emulator->exec_n(STEPS);
+
+    for (auto reg = 0; reg < 0x10; reg++) {
+      EXPECT_EQ(lanes.get(lane, as<regs>(reg)), emulator->get(as<regs>(reg)))
+          << "lane " << lane << " V" << reg;
+    }
+
+    for (auto addr = 0; addr < chip8::MEMORY_SIZE; addr++) {
+      ASSERT_EQ(lanes.read(lane, as<chip8::word>(addr)),
+                emulator->read(as<chip8::word>(addr)))
+          << "lane " << lane << " addr " << addr;
+    }
+
+    EXPECT_EQ(lanes.screen_hash(lane), emulator->screen_hash())
+        << "lane " << lane;
+  }
+
+  const auto& stats = lanes.stats();
+  EXPECT_EQ(stats.steps, STEPS);
+  EXPECT_EQ(stats.vector + stats.scalar, STEPS * Lanes);
+  EXPECT_GT(stats.vector, 0);
+}
+
+// Flags get overwritten within a pass, so every register is compared after
+// every step
+template <std::size_t Lanes, chip8::quirks Q>
+auto expect_alu_lockstep(chip8::profile value) -> void {
+  constexpr auto STEPS = 500UZ;
+
+  auto lanes = chip8::batch<Lanes, Q>{};
+  auto emulators = std::vector<chip8::chip8>(Lanes);
+
+  lanes.load_rom(alu_rom);
+
+  for (auto lane = 0UZ; lane < Lanes; lane++) {
+    lanes.seed(lane, lane);
+
+    emulators.at(lane).set_profile(value);
+    emulators.at(lane).seed(lane);
+    emulators.at(lane).load_rom(alu_rom);
+  }
+
+  for (auto step = 0UZ; step < STEPS; step++) {
+    lanes.step();
+
+    for (auto lane = 0UZ; lane < Lanes; lane++) {
+      auto& emulator = emulators.at(lane);
+      emulator.exec();
+
+      for (auto reg = 0; reg < 0x10; reg++) {
+        ASSERT_EQ(lanes.get(lane, as<regs>(reg)), emulator.get(as<regs>(reg)))
+            << "step " << step << " lane " << lane << " V" << reg;
+      }
+    }
+  }
+
+  EXPECT_EQ(lanes.stats().scalar, Lanes);
+}
+}  // namespace
+
+TEST(Batch, MatchesInterpreterVip) {
+  expect_lockstep<8, chip8::profiles::vip>(chip8::profile::vip);
+}
+
+TEST(Batch, MatchesInterpreterSchip) {
+  expect_lockstep<16, chip8::profiles::schip>(chip8::profile::schip);
+}
+
+TEST(Batch, MatchesInterpreterXochip) {
+  expect_lockstep<32, chip8::profiles::xochip>(chip8::profile::xochip);
+}
+
+TEST(Batch, AluMatchesInterpreterVip) {
+  expect_alu_lockstep<8, chip8::profiles::vip>(chip8::profile::vip);
+}
+
+TEST(Batch, AluMatchesInterpreterSchip) {
+  expect_alu_lockstep<16, chip8::profiles::schip>(chip8::profile::schip);
+}
+
+TEST(Batch, AluMatchesInterpreterXochip) {
+  expect_alu_lockstep<32, chip8::profiles::xochip>(chip8::profile::xochip);
+}
+
+TEST(Batch, InvalidLaneStops) {
+  auto lanes = chip8::batch<8>{};
+
+  lanes.load_rom(fixture::to_rom({op::LD(regs::V0, 0x01), op::JP(0x0202)}));
+  lanes.load_rom(3, fixture::to_rom({op::LD(regs::V0, 0x01), 0xffff}));
+
+  lanes.exec_n(10);
+
+  for (auto lane = 0UZ; lane < 8; lane++) {
+    EXPECT_EQ(lanes.is_invalid(lane), lane == 3);
+    EXPECT_EQ(lanes.get_pc(lane), lane == 3 ? 0x0204 : 0x0202);
+  }
+}
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+
+#include "common.h"
+#include "fixture.h"
+#include "instructions.h"
+
+namespace op = chip8::opcode;
+using chip8::regs;
+
+class BlockCache : public EmulatorFixture {
+ protected:
+  void SetUp() override { emulator.set_engine(chip8::engine::cached); }
+};
+
+TEST_F(BlockCache, HitsInLoop) {
+  emulator.load_program({
+      op::ADD(regs::V0, 0x01),
+      op::ADD(regs::V1, 0x02),
+      op::JP(0x0200),
+  });
+
+  emulator.exec_n(300);
+
+  const auto& stats = emulator.get_cache_stats();
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.hits, 99);
+  EXPECT_DOUBLE_EQ(stats.hit_rate(), 0.99);
+  EXPECT_EQ(emulator.get(regs::V0), 100);
+}
+
+TEST_F(BlockCache, WriteInvalidatesBlock) {
+  emulator.load_program({
+      op::ADD(regs::V0, 0x01),
+      op::JP(0x0200),
+  });
+
+  emulator.exec_n(4);
+  emulator.write16(0x0200, op::ADD(regs::V0, 0x10));
+  emulator.exec_n(4);
+
+  const auto& stats = emulator.get_cache_stats();
+  EXPECT_EQ(stats.invalidations, 1);
+  EXPECT_EQ(stats.misses, 2);
+  EXPECT_EQ(emulator.get(regs::V0), 0x22);
+}
+
+TEST_F(BlockCache, DataWritesKeepBlocks) {
+  emulator.load_program({
+      op::LD_I(0x0300),
+      op::LD_B(regs::V0),
+      op::ADD(regs::V0, 0x01),
+      op::JP(0x0202),
+  });
+
+  emulator.exec_n(31);
+
+  const auto& stats = emulator.get_cache_stats();
+  EXPECT_EQ(stats.invalidations, 0);
+  EXPECT_EQ(stats.misses, 2);
+}
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+#include <magic_enum/magic_enum.hpp>
+#include <string>
+
+#include "chip8.h"
+#include "common.h"
+#include "instructions.h"
+
+namespace op = chip8::opcode;
+using chip8::regs;
+
+namespace {
+constexpr auto program = op::instructions{
+    op::LD(regs::V0, 0x0a),            // 200
+    op::LD(regs::V1, 0x01),            // 202
+    op::CALL(0x021a),                  // 204
+    op::SUB(regs::V0, regs::V1),       // 206
+    op::SE(regs::V0, 0x00),            // 208
+    op::JP(0x0204),                    // 20a
+    op::LD_I(0x0300),                  // 20c
+    op::LD_B(regs::V2),                // 20e
+    op::LD_I(regs::V5),                // 210
+    op::LD_VX_I(regs::V3),             // 212
+    op::LD_F(regs::V2),                // 214
+    op::DRW(regs::V0, regs::V1, 0x5),  // 216
+    op::JP(0x0218),                    // 218
+    op::ADD(regs::V2, regs::V0),       // 21a
+    op::XOR(regs::V3, regs::V2),       // 21c
+    op::SHR(regs::V4, regs::V3),       // 21e
+    op::SHL(regs::V5, regs::V2),       // 220
+    op::OR(regs::V6, regs::V4),        // 222
+    op::AND(regs::V7, regs::V5),       // 224
+    op::SUBN(regs::V8, regs::V3),      // 226
+    op::ADD(regs::V9, 0x11),           // 228
+    op::SNE(regs::V9, 0x33),           // 22a
+    op::LD(regs::VA, 0x77),            // 22c
+    op::SE(regs::V2, regs::V3),        // 22e
+    op::ADD_I(regs::V2),               // 230
+    op::RET(),                         // 232
+};
+}  // namespace
+
+class Engine : public testing::TestWithParam<chip8::engine> {
+ protected:
+  chip8::chip8 reference;
+  chip8::chip8 emulator;
+};
+
+TEST_P(Engine, MatchesReference) {
+  reference.load_program(program);
+  emulator.load_program(program);
+  emulator.set_engine(GetParam());
+
+  for (auto step = 0; step < 200; step++) {
+    reference.exec();
+    emulator.exec();
+
+    for (auto idx = 0; idx < 0x10; idx++) {
+      auto reg = static_cast<regs>(idx);
+      ASSERT_EQ(emulator.get(reg), reference.get(reg)) << "step " << step;
+    }
+  }
+
+  EXPECT_EQ(emulator.dump_memory(), reference.dump_memory());
+}
+
+TEST_P(Engine, MatchesReferenceInBulk) {
+  reference.load_program(program);
+  emulator.load_program(program);
+  emulator.set_engine(GetParam());
+
+  reference.exec_n(200);
+  emulator.exec_n(200);
+
+  for (auto idx = 0; idx < 0x10; idx++) {
+    auto reg = static_cast<regs>(idx);
+    EXPECT_EQ(emulator.get(reg), reference.get(reg));
+  }
+
+  EXPECT_EQ(emulator.dump_memory(), reference.dump_memory());
+}
+
+TEST_P(Engine, SelfModifyingCode) {
+  emulator.set_engine(GetParam());
+  emulator.load_program({
+      op::CALL(0x0210),         // 200
+      op::LD(regs::V0, 0x72),   // 202
+      op::LD(regs::V1, 0x05),   // 204
+      op::LD_I(0x0210),         // 206
+      op::LD_I(regs::V1),       // 208
+      op::CALL(0x0210),         // 20a
+      op::JP(0x020c),           // 20c
+      op::LD(regs::V3, 0x00),   // 20e
+      op::ADD(regs::V2, 0x01),  // 210
+      op::RET(),                // 212
+  });
+
+  emulator.exec_n(20);
+
+  EXPECT_EQ(emulator.get(regs::V2), 0x06);
+}
+
+TEST_P(Engine, PatchesCurrentBlock) {
+  emulator.set_engine(GetParam());
+  emulator.load_program({
+      op::LD(regs::V0, 0x72),   // 200
+      op::LD(regs::V1, 0x05),   // 202
+      op::LD_I(0x020a),         // 204
+      op::LD_I(regs::V1),       // 206
+      op::LD(regs::V3, 0x00),   // 208
+      op::ADD(regs::V2, 0x01),  // 20a
+      op::JP(0x020c),           // 20c
+  });
+
+  emulator.exec_n(20);
+
+  EXPECT_EQ(emulator.get(regs::V2), 0x05);
+}
+
+TEST_P(Engine, InvalidOpcode) {
+  emulator.set_engine(GetParam());
+  emulator.load_program({op::LD(regs::V0, 0x01), 0x8008});
+
+  emulator.exec_n(4);
+
+  EXPECT_TRUE(emulator.is_invalid());
+  EXPECT_EQ(emulator.get(regs::V0), 0x01);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Engines, Engine,
+    testing::Values(chip8::engine::reference, chip8::engine::table,
+                    chip8::engine::threaded, chip8::engine::cached,
+                    chip8::engine::jit),
+    [](const auto& info) {
+      return std::string{magic_enum::enum_name(info.param)};
+    });
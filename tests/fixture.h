@@ -1,8 +1,67 @@
+#ifndef HK_CHIP8_FIXTURE_H
+#define HK_CHIP8_FIXTURE_H
+
 #include <gtest/gtest.h>
 
+#include <vector>
+
 #include "chip8.h"
+#include "common.h"
+#include "helpers.h"
+#include "instructions.h"
 
 class EmulatorFixture : public testing::Test {
  protected:
   chip8::chip8 emulator;
 };
+
+// Programs shared between tests
+namespace fixture {
+// Opcodes as they are laid out in a ROM file
+inline auto to_rom(chip8::opcode::instructions program)
+    -> std::vector<chip8::byte> {
+  auto rom = std::vector<chip8::byte>{};
+
+  for (auto opcode : program) {
+    rom.push_back(as<chip8::byte>(opcode >> 8));
+    rom.push_back(as<chip8::byte>(opcode & 0xff));
+  }
+
+  return rom;
+}
+
+// Keeps drawing random sprites and calling a subroutine
+inline auto load_drawing(chip8::chip8& emulator) -> void {
+  namespace op = chip8::opcode;
+  using chip8::regs;
+
+  emulator.load_program({
+      op::RND(regs::V0, 0x3f),         // 200
+      op::RND(regs::V1, 0x1f),         // 202
+      op::CALL(0x020a),                // 204
+      op::JP(0x0200),                  // 206
+      op::JP(0x0208),                  // 208
+      op::LD_F(regs::V0),              // 20a
+      op::DRW(regs::V0, regs::V1, 5),  // 20c
+      op::LD_DT(regs::V0),             // 20e
+      op::RET(),                       // 210
+  });
+}
+
+// Counts key presses into V1, drawing the key each time
+inline auto load_key_counter(chip8::chip8& emulator) -> void {
+  namespace op = chip8::opcode;
+  using chip8::regs;
+
+  emulator.load_program({
+      op::LD_KEY(regs::V0),            // 200
+      op::ADD(regs::V1, 0x01),         // 202
+      op::LD_F(regs::V0),              // 204
+      op::DRW(regs::V1, regs::V1, 5),  // 206
+      op::RND(regs::V2, 0xff),         // 208
+      op::JP(0x0200),                  // 20a
+  });
+}
+}  // namespace fixture
+
+#endif
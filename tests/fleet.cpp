@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+#include "common.h"
+#include "fixture.h"
+#include "fleet.h"
+#include "instructions.h"
+
+namespace op = chip8::opcode;
+using chip8::regs;
+
+namespace {
+const auto drawing = fixture::to_rom({
+    op::LD_F(regs::V0),              // 200
+    op::DRW(regs::V1, regs::V2, 5),  // 202
+    op::ADD(regs::V0, 0x01),         // 204
+    op::ADD(regs::V1, 0x05),         // 206
+    op::CLS(),                       // 208
+    op::JP(0x0200),                  // 20a
+});
+
+const auto invalid = fixture::to_rom({
+    op::LD(regs::V0, 0x01),  // 200
+    0xffff,                  // 202
+});
+}  // namespace
+
+TEST(Fleet, ResultsInQueueOrder) {
+  auto runner = chip8::fleet{{.instructions = 1'000, .threads = 4}};
+
+  auto first = runner.add(drawing, 5);
+  auto second = runner.add(invalid, 3);
+
+  auto results = runner.run();
+
+  ASSERT_EQ(results.size(), 8);
+  EXPECT_EQ(runner.size(), 8);
+
+  for (auto idx = 0UZ; idx < results.size(); idx++) {
+    const auto& result = results.at(idx);
+
+    if (idx < 5) {
+      EXPECT_EQ(result.rom, first);
+      EXPECT_FALSE(result.invalid);
+      EXPECT_EQ(result.instructions, 1'000);
+      EXPECT_EQ(result.screen_hash, results.front().screen_hash);
+    } else {
+      EXPECT_EQ(result.rom, second);
+      EXPECT_TRUE(result.invalid);
+      EXPECT_EQ(result.instructions, 2);
+    }
+  }
+}
+
+TEST(Fleet, RunsFrames) {
+  auto runner = chip8::fleet{{.frames = 10, .threads = 2}};
+
+  runner.add(drawing, 2);
+
+  for (const auto& result : runner.run()) {
+    EXPECT_EQ(result.instructions, 10 * chip8::DEFAULT_IPF);
+  }
+}
+
+TEST(Fleet, InstructionsTickTimers) {
+  const auto delayed = fixture::to_rom({
+      op::LD(regs::V0, 0x03),          // 200
+      op::LD_DT(regs::V0),             // 202
+      op::LD_VX_DT(regs::V1),          // 204
+      op::SE(regs::V1, 0x00),          // 206
+      op::JP(0x0204),                  // 208
+      op::LD_I(0x0210),                // 20a
+      op::DRW(regs::V2, regs::V2, 1),  // 20c
+      op::JP(0x020e),                  // 20e
+      0xff00,                          // 210
+  });
+
+  auto by_instructions =
+      chip8::fleet{{.instructions = 10 * chip8::DEFAULT_IPF, .threads = 1}};
+  auto by_frames = chip8::fleet{{.frames = 10, .threads = 1}};
+  auto blank = chip8::fleet{{.frames = 1, .threads = 1}};
+
+  by_instructions.add(delayed);
+  by_frames.add(delayed);
+  blank.add(delayed);
+
+  // The delay runs out and the sprite is drawn either way
+  auto expected = by_frames.run().front().screen_hash;
+  EXPECT_EQ(by_instructions.run().front().screen_hash, expected);
+  EXPECT_NE(blank.run().front().screen_hash, expected);
+}
+
+TEST(Fleet, ParksKeyWait) {
+  auto runner = chip8::fleet{{.frames = 10, .threads = 1}};
+
+  runner.add(fixture::to_rom({
+      op::LD(regs::V0, 0x01),  // 200
+      op::LD_KEY(regs::V1),    // 202
+  }));
+
+  auto results = runner.run();
+
+  ASSERT_EQ(results.size(), 1);
+  EXPECT_TRUE(results.front().waiting);
+  EXPECT_FALSE(results.front().invalid);
+  EXPECT_EQ(results.front().instructions, chip8::DEFAULT_IPF);
+}
+
+TEST(Fleet, SkipsMissingRom) {
+  auto runner = chip8::fleet{{.threads = 1}};
+
+  EXPECT_EQ(runner.add(std::filesystem::path{"/nonexistent/rom.ch8"}, 2),
+            std::nullopt);
+  EXPECT_EQ(runner.size(), 0);
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include "chip8.h"
+#include "common.h"
+#include "differential.h"
+#include "instructions.h"
+
+namespace op = chip8::opcode;
+using chip8::regs;
+
+class JIT : public testing::Test {
+ protected:
+  void SetUp() override { emulator.set_engine(chip8::engine::jit); }
+
+  chip8::chip8 emulator;
+  chip8::chip8 reference;
+};
+
+TEST_F(JIT, ArithmeticLoop) {
+  const auto program = op::instructions{
+      op::LD(regs::V1, 0x03),        // 200
+      op::LD(regs::V2, 0x81),        // 202
+      op::ADD(regs::V0, 0x07),       // 204
+      op::ADD(regs::V1, regs::V0),   // 206
+      op::SUB(regs::V2, regs::V1),   // 208
+      op::SUBN(regs::V3, regs::V2),  // 20a
+      op::SHR(regs::V4, regs::V1),   // 20c
+      op::SHL(regs::V5, regs::V2),   // 20e
+      op::OR(regs::V6, regs::V5),    // 210
+      op::AND(regs::V7, regs::V6),   // 212
+      op::XOR(regs::V8, regs::V3),   // 214
+      op::LD(regs::V9, regs::V8),    // 216
+      op::ADD(regs::VF, regs::V9),   // 218
+      op::LD_I(0x0300),              // 21a
+      op::ADD_I(regs::V4),           // 21c
+      op::LD_B(regs::V1),            // 21e
+      op::ADD(regs::VA, 0x01),       // 220
+      op::SNE(regs::VA, 0x00),       // 222
+      op::JP(0x0228),                // 224
+      op::JP(0x0204),                // 226
+      op::JP(0x0228),                // 228
+  };
+
+  emulator.load_program(program);
+  reference.load_program(program);
+
+  auto diff = chip8::run_lockstep(emulator, reference, 20'000, 17);
+
+  EXPECT_FALSE(diff) << diff->reason;
+  EXPECT_EQ(emulator.get(regs::VA), 0x00);
+
+  if (chip8::jit::supported()) {
+    EXPECT_GT(emulator.get_cache_stats().compiled, 0);
+  } else {
+    // Nothing was compiled, so nothing is counted
+    EXPECT_EQ(emulator.get_cache_stats().compiled, 0);
+  }
+}
+
+TEST_F(JIT, ExitsWhenCodeIsPatched) {
+  // The hot block at 204 writes over the block at 240 on every iteration
+  const auto program = op::instructions{
+      op::CALL(0x0240),         // 200
+      op::NOP(),                // 202
+      op::LD(regs::V0, 0x71),   // 204
+      op::LD(regs::V1, 0x01),   // 206
+      op::LD_I(0x0240),         // 208
+      op::LD_I(regs::V1),       // 20a
+      op::ADD(regs::V2, 0x01),  // 20c
+      op::CALL(0x0240),         // 20e
+      op::JP(0x0204),           // 210
+  };
+
+  emulator.load_program(program);
+  reference.load_program(program);
+  emulator.write16(0x0240, op::ADD(regs::V3, 0x01));
+  reference.write16(0x0240, op::ADD(regs::V3, 0x01));
+  emulator.write16(0x0242, op::RET());
+  reference.write16(0x0242, op::RET());
+
+  auto diff = chip8::run_lockstep(emulator, reference, 2'000, 7);
+
+  EXPECT_FALSE(diff) << diff->reason;
+  EXPECT_EQ(emulator.get(regs::V3), 0x01);
+
+  if (chip8::jit::supported()) {
+    EXPECT_GT(emulator.get_cache_stats().compiled, 0);
+  }
+}
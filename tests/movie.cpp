@@ -0,0 +1,98 @@
+#include "movie.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <sstream>
+#include <vector>
+
+#include "chip8.h"
+#include "common.h"
+#include "fixture.h"
+#include "frontend.h"
+#include "keyboard.h"
+
+using chip8::keys;
+using chip8::regs;
+
+namespace {
+// Taps 5 on the second frame, holds A over frames 4 to 6
+struct script final : chip8::input {
+  auto poll(std::vector<chip8::key_event>& events) -> void override {
+    if (frame == 2) {
+      events.push_back({.at = 0, .key = keys::KEY_5, .down = true});
+      events.push_back({.at = 0, .key = keys::KEY_5, .down = false});
+    } else if (frame == 4 or frame == 7) {
+      events.push_back({.at = 0, .key = keys::KEY_A, .down = frame == 4});
+    }
+
+    frame++;
+  }
+
+  int frame{};
+};
+}  // namespace
+
+TEST(Movie, SavesAndLoads) {
+  auto value = chip8::movie{
+      .seed = 42,
+      .rom_hash = 0x0123456789abcdef,
+      .cpu_profile = chip8::profile::schip,
+      .ipf = 20,
+      .timer_period = 0,
+      .frames = 600,
+      .state_hash = 0xfedcba9876543210,
+      .inputs = {{.frame = 2, .keys = 0x0020}, {.frame = 2, .keys = 0x0000}},
+  };
+
+  auto out = std::stringstream{};
+  value.save(out);
+
+  EXPECT_EQ(chip8::movie::load(out), value);
+}
+
+TEST(Movie, ReplayReachesRecordedState) {
+  auto recording = chip8::movie{.seed = 7};
+
+  {
+    auto source = script{};
+    auto recorder = chip8::movie_recorder{source, recording};
+    auto emulator = chip8::chip8{};
+
+    emulator.set_input(recorder);
+    emulator.seed(recording.seed);
+    fixture::load_key_counter(emulator);
+
+    for (auto frame = 0; frame < 10; frame++) {
+      emulator.exec_frame();
+    }
+
+    EXPECT_EQ(emulator.get(regs::V1), 0x02);
+
+    recording.frames = emulator.frames();
+    recording.state_hash = emulator.state_hash();
+  }
+
+  EXPECT_EQ(recording.inputs.size(), 4);
+
+  auto player = chip8::movie_player{recording};
+  auto emulator = chip8::chip8{};
+
+  emulator.set_input(player);
+  emulator.set_engine(chip8::engine::cached);
+  emulator.seed(recording.seed);
+  fixture::load_key_counter(emulator);
+
+  for (auto frame = 0ULL; frame < recording.frames; frame++) {
+    emulator.exec_frame();
+  }
+
+  EXPECT_EQ(emulator.state_hash(), recording.state_hash);
+}
+
+TEST(Movie, MissingRomHasNoHash) {
+  EXPECT_EQ(chip8::rom_hash(std::filesystem::path{"/nonexistent/rom.ch8"}),
+            std::nullopt);
+}
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include <magic_enum/magic_enum.hpp>
+#include <string>
+
+#include "chip8.h"
+#include "common.h"
+#include "instructions.h"
+#include "quirks.h"
+
+namespace op = chip8::opcode;
+using chip8::regs;
+
+namespace {
+const auto program = op::instructions{
+    op::LD(regs::V0, 0xaa),          // 200
+    op::LD(regs::V1, 0x81),          // 202
+    op::LD(regs::V2, 0x03),          // 204
+    op::SHR(regs::V1, regs::V2),     // 206
+    op::LD(regs::V3, regs::VF),      // 208
+    op::LD(regs::VF, 0x01),          // 20a
+    op::OR(regs::V4, regs::V5),      // 20c
+    op::LD(regs::V6, regs::VF),      // 20e
+    op::LD_I(0x0300),                // 210
+    op::LD_I(regs::V0),              // 212
+    op::LD_I(regs::V0),              // 214
+    op::LD(regs::V7, 0x00),          // 216
+    op::LD_I(0x0240),                // 218
+    op::DRW(regs::V7, regs::V7, 1),  // 21a
+    op::LD(regs::V8, 0x3e),          // 21c
+    op::DRW(regs::V8, regs::V7, 1),  // 21e
+    op::LD(regs::V9, regs::VF),      // 220
+    op::LD(regs::V0, 0x00),          // 222
+    op::LD(regs::V2, 0x04),          // 224
+    op::JP_V0(0x022a),               // 226
+    op::JP(0x0228),                  // 228
+    op::LD(regs::VA, 0x01),          // 22a
+    op::JP(0x022c),                  // 22c
+    op::LD(regs::VA, 0x02),          // 22e
+    op::JP(0x0230),                  // 230
+};
+
+struct expected {
+  chip8::profile profile;
+  chip8::byte shifted;
+  chip8::byte flag_after_or;
+  chip8::byte second_store;
+  chip8::byte wrapped_collision;
+  chip8::byte jumped_to;
+};
+}  // namespace
+
+class Quirks : public testing::TestWithParam<expected> {
+ protected:
+  auto run(chip8::chip8& emulator, chip8::engine engine) -> void {
+    emulator.set_profile(GetParam().profile);
+    emulator.set_engine(engine);
+    emulator.load_program(program);
+    emulator.write(0x0240, 0xff);
+    emulator.exec_n(100);
+  }
+};
+
+TEST_P(Quirks, Profile) {
+  const auto& want = GetParam();
+
+  auto emulator = chip8::chip8{};
+  run(emulator, chip8::engine::reference);
+
+  EXPECT_EQ(emulator.get(regs::V1), want.shifted);
+  EXPECT_EQ(emulator.get(regs::V3), 0x01);
+  EXPECT_EQ(emulator.get(regs::V6), want.flag_after_or);
+  EXPECT_EQ(emulator.read(0x0301), want.second_store);
+  EXPECT_EQ(emulator.get(regs::V9), want.wrapped_collision);
+  EXPECT_EQ(emulator.get(regs::VA), want.jumped_to);
+}
+
+TEST_P(Quirks, EnginesAgree) {
+  auto reference = chip8::chip8{};
+  run(reference, chip8::engine::reference);
+
+  for (auto engine : magic_enum::enum_values<chip8::engine>()) {
+    auto emulator = chip8::chip8{};
+    run(emulator, engine);
+
+    auto diff = emulator.compare(reference);
+    EXPECT_FALSE(diff) << magic_enum::enum_name(engine) << ": " << *diff;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Profiles, Quirks,
+    testing::Values(
+        expected{.profile = chip8::profile::vip,
+                 .shifted = 0x01,
+                 .flag_after_or = 0x00,
+                 .second_store = 0xaa,
+                 .wrapped_collision = 0x00,
+                 .jumped_to = 0x01},
+        expected{.profile = chip8::profile::schip,
+                 .shifted = 0x40,
+                 .flag_after_or = 0x01,
+                 .second_store = 0x00,
+                 .wrapped_collision = 0x00,
+                 .jumped_to = 0x02},
+        expected{.profile = chip8::profile::xochip,
+                 .shifted = 0x01,
+                 .flag_after_or = 0x01,
+                 .second_store = 0xaa,
+                 .wrapped_collision = 0x01,
+                 .jumped_to = 0x01}),
+    [](const auto& info) {
+      return std::string{magic_enum::enum_name(info.param.profile)};
+    });
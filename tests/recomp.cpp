@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <ranges>
+#include <span>
+#include <vector>
+
+#include "block_cache.h"
+#include "common.h"
+#include "fixture.h"
+#include "instructions.h"
+#include "recompiler.h"
+
+namespace op = chip8::opcode;
+using chip8::byte;
+using chip8::regs;
+using chip8::word;
+
+class Recompiler : public EmulatorFixture {
+ protected:
+  auto starts() -> std::vector<word> {
+    auto blocks = chip8::recover_blocks(emulator.dump_memory(), 0x0200);
+    auto result = std::vector<word>{};
+
+    for (const auto& block : blocks) {
+      result.push_back(block.start);
+    }
+
+    return result;
+  }
+};
+
+// Stands in for a generated block, runs the two ADD V0, 1 and leaves the
+// branch ending it to the interpreter
+auto add_twice_runs = 0;
+
+auto add_twice(chip8::chip8* /*cpu*/, byte* regs, word* /*reg_i*/, word* pc)
+    -> std::uint32_t {
+  add_twice_runs++;
+  regs[0] += 2;
+  *pc += 4;
+  return 2;
+}
+
+TEST_F(Recompiler, FollowsBranches) {
+  emulator.load_program({
+      op::LD(regs::V0, 0x01),   // 200
+      op::SE(regs::V0, 0x01),   // 202
+      op::CALL(0x020c),         // 204
+      op::JP(0x0210),           // 206
+      op::LD(regs::V2, 0x00),   // 208
+      op::LD(regs::V2, 0x00),   // 20a
+      op::ADD(regs::V1, 0x01),  // 20c
+      op::RET(),                // 20e
+      op::JP(0x0210),           // 210
+  });
+
+  EXPECT_EQ(starts(),
+            (std::vector<word>{0x0200, 0x0204, 0x0206, 0x020c, 0x0210}));
+}
+
+TEST_F(Recompiler, SkipsUnreachableCode) {
+  emulator.load_program({
+      op::JP(0x0204),           // 200
+      op::ADD(regs::V0, 0x01),  // 202
+      op::JP(0x0204),           // 204
+  });
+
+  EXPECT_EQ(starts(), (std::vector<word>{0x0200, 0x0204}));
+}
+
+TEST_F(Recompiler, RunsInstalledBlocks) {
+  const auto program = op::instructions{
+      op::ADD(regs::V0, 0x01),  // 200
+      op::ADD(regs::V0, 0x01),  // 202
+      op::JP(0x0200),           // 204
+  };
+
+  const auto source = fixture::to_rom(program);
+  const auto native = std::to_array<chip8::native_entry>({
+      {.start = 0x0200, .size = 3, .source = source, .code = &add_twice},
+  });
+
+  emulator.load_program(program);
+
+  emulator.set_engine(chip8::engine::recompiled);
+  emulator.install_native(native);
+
+  emulator.exec_n(3);
+  EXPECT_EQ(emulator.get(regs::V0), 0x02);
+
+  emulator.exec_n(30);
+  EXPECT_EQ(emulator.get(regs::V0), 0x16);
+}
+
+TEST_F(Recompiler, DropsPatchedBlocks) {
+  const auto program = op::instructions{
+      op::ADD(regs::V0, 0x01),  // 200
+      op::ADD(regs::V0, 0x01),  // 202
+      op::RET(),                // 204
+  };
+
+  const auto source = fixture::to_rom(program);
+  const auto native = std::to_array<chip8::native_entry>({
+      {.start = 0x0200, .size = 3, .source = source, .code = &add_twice},
+  });
+
+  emulator.load_program(program);
+
+  emulator.set_engine(chip8::engine::recompiled);
+  emulator.install_native(native);
+  emulator.write16(0x0202, op::ADD(regs::V0, 0x10));
+
+  emulator.exec_n(2);
+  EXPECT_EQ(emulator.get(regs::V0), 0x11);
+}
+
+TEST_F(Recompiler, ReattachesAfterNearbyWrite) {
+  const auto program = op::instructions{
+      op::ADD(regs::V0, 0x01),  // 200
+      op::ADD(regs::V0, 0x01),  // 202
+      op::JP(0x0200),           // 204
+      0x0000,                   // 206
+  };
+
+  const auto source = fixture::to_rom(program);
+  const auto native = std::to_array<chip8::native_entry>({
+      {.start = 0x0200, .size = 3, .source = std::span{source}.first(6),
+       .code = &add_twice},
+  });
+
+  emulator.load_program(program);
+  emulator.set_engine(chip8::engine::recompiled);
+  emulator.install_native(native);
+
+  add_twice_runs = 0;
+  emulator.exec_n(3);
+  EXPECT_EQ(add_twice_runs, 1);
+
+  // Data in the same page drops the block, the bytes it came from are intact
+  emulator.write16(0x0206, 0x1234);
+
+  emulator.exec_n(3);
+  EXPECT_EQ(add_twice_runs, 2);
+  EXPECT_EQ(emulator.get(regs::V0), 0x04);
+}
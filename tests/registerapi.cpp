@@ -1,7 +1,13 @@
 #include <gtest/gtest.h>
 
+#include <cstdint>
+#include <memory>
+
+#include "chip8.h"
 #include "common.h"
 #include "fixture.h"
+#include "instructions.h"
+#include "random.h"
 
 using RegisterAPI = EmulatorFixture;
 
@@ -59,3 +65,27 @@ TEST_F(RegisterAPI, GetMethod) {
   EXPECT_EQ(emulator.get(chip8::regs::VE), 0xef);
   EXPECT_EQ(emulator.get(chip8::regs::VF), 0xf0);
 }
+
+TEST_F(RegisterAPI, SeededRandomRepeats) {
+  auto other = chip8::chip8{};
+
+  emulator.seed(0x1234);
+  other.seed(0x1234);
+
+  for (auto idx = 0; idx < 64; idx++) {
+    EXPECT_EQ(emulator.get_random(), other.get_random());
+  }
+}
+
+TEST_F(RegisterAPI, ReplacedRandomSource) {
+  struct constant final : chip8::random_source {
+    auto seed(std::uint64_t /* value */) -> void override {}
+    auto next() -> chip8::byte override { return 0x5a; }
+  };
+
+  emulator.set_random(std::make_unique<constant>());
+  emulator.load_program({chip8::opcode::RND(chip8::regs::V0, 0x0f)});
+  emulator.exec();
+
+  EXPECT_EQ(emulator.get(chip8::regs::V0), 0x0a);
+}
@@ -0,0 +1,148 @@
+#include "rewind.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "chip8.h"
+#include "common.h"
+#include "fixture.h"
+
+using Rewind = EmulatorFixture;
+
+TEST_F(Rewind, StepsBackThroughKeyframes) {
+  emulator.seed(1);
+  fixture::load_drawing(emulator);
+
+  auto buffer = chip8::rewind_buffer{100, 1 << 20, 8};
+  auto hashes = std::vector<std::uint64_t>{};
+
+  for (auto frame = 0; frame < 30; frame++) {
+    emulator.exec_frame();
+    buffer.push(emulator.save_state());
+    hashes.push_back(emulator.state_hash());
+  }
+
+  EXPECT_EQ(buffer.frames(), 30);
+
+  // Deltas undo themselves, keyframes are rebuilt from the one before
+  for (auto frame = 28; frame >= 0; frame--) {
+    auto state = buffer.step_back();
+    ASSERT_TRUE(state.has_value());
+
+    emulator.load_state(*state);
+    EXPECT_EQ(emulator.state_hash(), hashes.at(frame)) << frame;
+  }
+
+  EXPECT_EQ(buffer.step_back(), std::nullopt);
+}
+
+TEST_F(Rewind, DeltasAreSmall) {
+  emulator.seed(1);
+  fixture::load_drawing(emulator);
+
+  auto buffer = chip8::rewind_buffer{120, 1 << 20};
+
+  for (auto frame = 0; frame < 120; frame++) {
+    emulator.exec_frame();
+    buffer.push(emulator.save_state());
+  }
+
+  // Two keyframes, the rest a few registers and screen rows each, well under
+  // a tenth of keeping every state whole
+  EXPECT_LT(buffer.bytes(), 12 * sizeof(chip8::machine_state));
+}
+
+TEST_F(Rewind, KeepsWithinBudget) {
+  emulator.seed(1);
+  fixture::load_drawing(emulator);
+
+  auto bytes = 3 * sizeof(chip8::machine_state);
+  auto buffer = chip8::rewind_buffer{50, bytes, 4};
+  auto hashes = std::vector<std::uint64_t>{};
+
+  for (auto frame = 0; frame < 200; frame++) {
+    emulator.exec_frame();
+    buffer.push(emulator.save_state());
+    hashes.push_back(emulator.state_hash());
+
+    EXPECT_LE(buffer.bytes(), bytes);
+    EXPECT_LE(buffer.frames(), 50);
+  }
+
+  // Only the newest frames are left, and they're intact
+  auto frames = buffer.frames();
+  ASSERT_GT(frames, 1);
+
+  for (auto back = 1UZ; back < frames; back++) {
+    auto state = buffer.step_back();
+    ASSERT_TRUE(state.has_value());
+
+    emulator.load_state(*state);
+    EXPECT_EQ(emulator.state_hash(), hashes.at(hashes.size() - 1 - back));
+  }
+
+  EXPECT_EQ(buffer.step_back(), std::nullopt);
+}
+
+TEST_F(Rewind, InterpreterRewindsAFrame) {
+  emulator.seed(1);
+  fixture::load_drawing(emulator);
+
+  EXPECT_FALSE(emulator.rewind());
+
+  emulator.set_rewind(60, 1 << 20);
+
+  auto hashes = std::vector<std::uint64_t>{emulator.state_hash()};
+
+  for (auto frame = 0; frame < 10; frame++) {
+    emulator.exec_frame();
+    hashes.push_back(emulator.state_hash());
+  }
+
+  ASSERT_TRUE(emulator.rewind());
+  ASSERT_TRUE(emulator.rewind());
+  EXPECT_EQ(emulator.state_hash(), hashes.at(8));
+
+  // Runs on the same way from there
+  emulator.exec_frame();
+  EXPECT_EQ(emulator.state_hash(), hashes.at(9));
+
+  ASSERT_TRUE(emulator.rewind());
+  EXPECT_EQ(emulator.state_hash(), hashes.at(8));
+}
+
+TEST_F(Rewind, KeysStayAsTheyAre) {
+  emulator.seed(1);
+  fixture::load_drawing(emulator);
+  emulator.set_rewind(60, 1 << 20);
+
+  emulator.exec_frame();
+  emulator.exec_frame();
+
+  // Held down after the frame rewound to, and let go a few instructions in
+  auto now = emulator.instructions();
+  emulator.schedule({.at = now, .key = chip8::keys::KEY_5, .down = true});
+  emulator.schedule({.at = now + 3, .key = chip8::keys::KEY_5, .down = false});
+  emulator.schedule({.at = now, .key = chip8::keys::KEY_7, .down = true});
+  emulator.exec_frame();
+
+  ASSERT_TRUE(emulator.save_state().keyboard.is_pressed(chip8::keys::KEY_7));
+  ASSERT_FALSE(emulator.save_state().keyboard.is_pressed(chip8::keys::KEY_5));
+
+  emulator.schedule({.at = emulator.instructions() + 3,
+                     .key = chip8::keys::KEY_7,
+                     .down = false});
+
+  ASSERT_TRUE(emulator.rewind());
+
+  // Still held, though the frame before had no key down
+  EXPECT_TRUE(emulator.save_state().keyboard.is_pressed(chip8::keys::KEY_7));
+  EXPECT_EQ(emulator.instructions(), now);
+
+  // The pending release lands as far into the next frame as it was going to
+  emulator.exec_frame();
+  EXPECT_FALSE(emulator.save_state().keyboard.is_pressed(chip8::keys::KEY_7));
+}
@@ -0,0 +1,319 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "common.h"
+#include "fixture.h"
+#include "frontend.h"
+#include "instructions.h"
+#include "keyboard.h"
+#include "screen.h"
+
+namespace op = chip8::opcode;
+using chip8::regs;
+
+using Scheduler = EmulatorFixture;
+
+TEST_F(Scheduler, ExecDoesNotTickTimers) {
+  emulator.load_program({
+      op::LD(regs::V0, 0x05),
+      op::LD_DT(regs::V0),
+      op::LD(regs::V2, 0x00),
+      op::LD(regs::V2, 0x00),
+      op::LD_VX_DT(regs::V1),
+  });
+
+  emulator.exec_n(5);
+
+  EXPECT_EQ(emulator.get(regs::V1), 0x05);
+}
+
+TEST_F(Scheduler, FrameTicksTimersOnce) {
+  emulator.load_program({
+      op::LD(regs::V0, 0x05),
+      op::LD_DT(regs::V0),
+      op::LD_VX_DT(regs::V1),
+      op::JP(0x0204),
+  });
+
+  emulator.set_ipf(3);
+  emulator.exec_frame();
+  emulator.exec_n(2);
+
+  EXPECT_EQ(emulator.get(regs::V1), 0x04);
+}
+
+TEST_F(Scheduler, InstructionsPerFrame) {
+  emulator.load_program({
+      op::ADD(regs::V0, 0x01),
+      op::JP(0x0200),
+  });
+
+  emulator.set_ipf(10);
+  emulator.exec_frame();
+
+  EXPECT_EQ(emulator.get(regs::V0), 0x05);
+}
+
+TEST_F(Scheduler, KeyWaitsForPressAndRelease) {
+  emulator.load_program({
+      op::LD_KEY(regs::V0),
+      op::LD(regs::V1, 0x01),
+  });
+
+  emulator.exec_n(4);
+  EXPECT_EQ(emulator.get(regs::V1), 0x00);
+
+  emulator.press(chip8::keys::KEY_A);
+  emulator.exec_n(4);
+  EXPECT_EQ(emulator.get(regs::V1), 0x00);
+
+  emulator.release();
+  emulator.exec_n(2);
+  EXPECT_EQ(emulator.get(regs::V0), 0x0a);
+  EXPECT_EQ(emulator.get(regs::V1), 0x01);
+}
+
+TEST_F(Scheduler, ParksOnKeyWait) {
+  emulator.load_program({
+      op::LD(regs::V0, 0x03),   // 200
+      op::LD_DT(regs::V0),      // 202
+      op::LD_KEY(regs::V1),     // 204
+      op::ADD(regs::V2, 0x01),  // 206
+      op::JP(0x0206),           // 208
+  });
+
+  emulator.set_ipf(10);
+  emulator.exec_frame();
+
+  // The rest of the frame passes without running anything
+  EXPECT_TRUE(emulator.waiting_for_key());
+  EXPECT_EQ(emulator.instructions(), 10);
+  EXPECT_EQ(emulator.get(regs::V2), 0x00);
+
+  // Frames and timers keep going while parked
+  emulator.exec_frame();
+  EXPECT_TRUE(emulator.waiting_for_key());
+  EXPECT_EQ(emulator.instructions(), 20);
+  EXPECT_EQ(emulator.timer_ticks(), 2);
+
+  emulator.press(chip8::keys::KEY_7);
+  emulator.exec_frame();
+  EXPECT_TRUE(emulator.waiting_for_key());
+
+  emulator.release();
+  emulator.exec_frame();
+  EXPECT_FALSE(emulator.waiting_for_key());
+  EXPECT_EQ(emulator.get(regs::V1), 0x07);
+  EXPECT_EQ(emulator.get(regs::V2), 0x05);
+}
+
+TEST_F(Scheduler, DebugShellResumesParkedProgram) {
+  emulator.load_program({
+      op::LD_KEY(regs::V1),     // 200
+      op::ADD(regs::V2, 0x01),  // 202
+      op::JP(0x0202),           // 204
+  });
+
+  emulator.set_ipf(10);
+  emulator.exec_frame();
+  EXPECT_TRUE(emulator.waiting_for_key());
+
+  // Parked until the shell presses and releases a key
+  auto input = std::istringstream{"press KEY_5\nsi\npress NONE\nsi\nexit\n"};
+  auto* saved = std::cin.rdbuf(input.rdbuf());
+  emulator.debug_shell();
+  std::cin.rdbuf(saved);
+
+  EXPECT_FALSE(emulator.waiting_for_key());
+  EXPECT_EQ(emulator.get(regs::V1), 0x05);
+}
+
+TEST_F(Scheduler, SkipsDelayTimerLoop) {
+  const auto program = op::instructions{
+      op::LD(regs::V0, 0x03),   // 200
+      op::LD_DT(regs::V0),      // 202
+      op::LD_VX_DT(regs::V1),   // 204
+      op::SE(regs::V1, 0x00),   // 206
+      op::JP(0x0204),           // 208
+      op::ADD(regs::V2, 0x01),  // 20a
+      op::JP(0x020c),           // 20c
+  };
+
+  // Ticks the timers by hand after every frame's worth of instructions
+  auto reference = chip8::chip8{};
+
+  emulator.load_program(program);
+  reference.load_program(program);
+  emulator.set_ipf(100);
+
+  for (auto frame = 0; frame < 6; frame++) {
+    emulator.exec_frame();
+    reference.exec_n(100);
+    reference.dt_tick();
+    reference.st_tick();
+
+    auto diff = emulator.compare(reference);
+    EXPECT_FALSE(diff) << "frame " << frame << ": " << *diff;
+  }
+
+  EXPECT_EQ(emulator.get(regs::V2), 0x01);
+  EXPECT_EQ(emulator.frames(), 6);
+  EXPECT_EQ(emulator.idle_frames(), 4);
+}
+
+TEST_F(Scheduler, InstructionClockedTimers) {
+  emulator.load_program({
+      op::LD(regs::V0, 0x05),   // 200
+      op::LD_DT(regs::V0),      // 202
+      op::LD_VX_DT(regs::V1),   // 204
+      op::JP(0x0204),           // 206
+  });
+
+  emulator.set_timer_period(10);
+
+  // The tick lands after the tenth instruction, inside a single exec_n()
+  emulator.exec_n(9);
+  EXPECT_EQ(emulator.get(regs::V1), 0x05);
+
+  emulator.exec_n(2);
+  EXPECT_EQ(emulator.get(regs::V1), 0x04);
+  EXPECT_EQ(emulator.timer_ticks(), 1);
+
+  // Frames no longer tick the timers
+  emulator.set_ipf(8);
+  emulator.exec_frame();
+  EXPECT_EQ(emulator.get(regs::V1), 0x04);
+  EXPECT_EQ(emulator.frames(), 1);
+  EXPECT_EQ(emulator.timer_ticks(), 1);
+}
+
+TEST_F(Scheduler, SkipsJumpToItself) {
+  emulator.load_program({
+      op::ADD(regs::V0, 0x01),  // 200
+      op::JP(0x0202),           // 202
+  });
+
+  emulator.exec_frame();
+  emulator.exec_frame();
+
+  EXPECT_EQ(emulator.get(regs::V0), 0x01);
+  EXPECT_EQ(emulator.idle_frames(), 1);
+}
+
+TEST_F(Scheduler, FrameGoesThroughFrontend) {
+  struct recorder final : chip8::display, chip8::input, chip8::audio {
+    auto present(const chip8::screen& value) -> void override {
+      hash = value.hash();
+      frames++;
+    }
+    auto closed() -> bool override { return false; }
+
+    auto poll(std::vector<chip8::key_event>& events) -> void override {
+      events.push_back({.at = 0, .key = chip8::keys::KEY_5, .down = true});
+    }
+
+    auto tone(bool on) -> void override { beeping = on; }
+
+    std::uint64_t hash{};
+    int frames{};
+    bool beeping{};
+  };
+
+  auto frontend = recorder{};
+  emulator.set_display(frontend);
+  emulator.set_input(frontend);
+  emulator.set_audio(frontend);
+
+  emulator.load_program({
+      op::LD(regs::V0, 0x05),          // 200
+      op::LD_ST(regs::V0),             // 202
+      op::LD_I(0x0050),                // 204
+      op::SKNP(regs::V0),              // 206
+      op::DRW(regs::V0, regs::V0, 1),  // 208
+      op::JP(0x020a),                  // 20a
+  });
+
+  emulator.set_ipf(6);
+  emulator.exec_frame();
+
+  EXPECT_EQ(frontend.frames, 1);
+  EXPECT_TRUE(frontend.beeping);
+  EXPECT_EQ(frontend.hash, emulator.screen_hash());
+  EXPECT_NE(frontend.hash, chip8::screen{}.hash());
+}
+
+TEST_F(Scheduler, KeyEventsApplyAtExactInstruction) {
+  emulator.load_program({
+      op::LD(regs::V0, 0x05),   // 200
+      op::ADD(regs::V1, 0x01),  // 202
+      op::SKP(regs::V0),        // 204
+      op::JP(0x0202),           // 206
+      op::JP(0x0208),           // 208
+  });
+
+  emulator.schedule({.at = 10, .key = chip8::keys::KEY_5, .down = true});
+  emulator.exec_n(100);
+
+  // Three whole iterations ran before the press
+  EXPECT_EQ(emulator.get(regs::V1), 0x04);
+}
+
+TEST_F(Scheduler, ExecRunsLikeExecN) {
+  emulator.load_program({
+      op::LD(regs::V0, 0x05),   // 200
+      op::ADD(regs::V1, 0x01),  // 202
+      op::SKP(regs::V0),        // 204
+      op::JP(0x0202),           // 206
+      0xffff,                   // 208
+  });
+
+  emulator.schedule({.at = 10, .key = chip8::keys::KEY_5, .down = true});
+
+  for (auto step = 0; step < 100; step++) {
+    emulator.exec();
+  }
+
+  // Key events apply on time and nothing runs past the invalid opcode
+  EXPECT_EQ(emulator.get(regs::V1), 0x04);
+  EXPECT_TRUE(emulator.is_invalid());
+  EXPECT_EQ(emulator.instructions(), 13);
+}
+
+TEST_F(Scheduler, TapBetweenPollsLastsAFrame) {
+  struct tapper final : chip8::input {
+    auto poll(std::vector<chip8::key_event>& events) -> void override {
+      if (not tapped) {
+        events.push_back({.at = 0, .key = chip8::keys::KEY_5, .down = true});
+        events.push_back({.at = 0, .key = chip8::keys::KEY_5, .down = false});
+        tapped = true;
+      }
+    }
+
+    bool tapped{};
+  };
+
+  auto frontend = tapper{};
+  emulator.set_input(frontend);
+
+  emulator.load_program({
+      op::LD(regs::V0, 0x05),  // 200
+      op::SKP(regs::V0),       // 202
+      op::JP(0x0202),          // 204
+      op::LD(regs::V1, 0x01),  // 206
+      op::SKNP(regs::V0),      // 208
+      op::JP(0x0208),          // 20a
+      op::LD(regs::V2, 0x01),  // 20c
+      op::JP(0x020e),          // 20e
+  });
+
+  emulator.exec_frame();
+  EXPECT_EQ(emulator.get(regs::V1), 0x01);
+  EXPECT_EQ(emulator.get(regs::V2), 0x00);
+
+  emulator.exec_frame();
+  EXPECT_EQ(emulator.get(regs::V2), 0x01);
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <bitset>
+
+#include "common.h"
+#include "fixture.h"
+#include "frontend.h"
+#include "instructions.h"
+#include "screen.h"
+
+namespace op = chip8::opcode;
+using chip8::regs;
+
+using Screen = EmulatorFixture;
+
+namespace {
+// Keeps the dirty rows of every presented frame
+struct recorder final : chip8::display {
+  auto present(const chip8::screen& value) -> void override {
+    rows = value.dirty_rows();
+  }
+  auto closed() -> bool override { return false; }
+
+  std::bitset<chip8::HEIGHT> rows;
+};
+}  // namespace
+
+TEST(ScreenDirty, WritesMarkRows) {
+  auto value = chip8::screen{};
+  EXPECT_TRUE(value.dirty_rows().all());
+
+  value.mark_clean();
+  EXPECT_FALSE(value.dirty());
+
+  value[3, 7] = true;
+  EXPECT_TRUE(value.dirty_rows().test(7));
+  EXPECT_EQ(value.dirty_rows().count(), 1);
+
+  value.mark_clean();
+  value.clear();
+  EXPECT_TRUE(value.dirty_rows().all());
+}
+
+TEST(ScreenDraw, SpriteRows) {
+  EXPECT_EQ(chip8::sprite_row(0xc1, 0, false), 0b1000'0011);
+  EXPECT_EQ(chip8::sprite_row(0x81, 60, false), (1ULL << 60) | (1ULL << 3));
+  EXPECT_EQ(chip8::sprite_row(0x81, 60, true), 1ULL << 60);
+
+  auto value = chip8::screen{};
+  EXPECT_FALSE(value.draw(0, 0b0110));
+  EXPECT_TRUE(value.draw(0, 0b0011));
+  EXPECT_TRUE((value[0, 0]));
+  EXPECT_FALSE((value[1, 0]));
+  EXPECT_TRUE((value[2, 0]));
+}
+
+TEST_F(Screen, PresentsChangedRowsOnly) {
+  auto frontend = recorder{};
+  emulator.set_display(frontend);
+
+  emulator.load_program({
+      op::LD(regs::V0, 0x04),          // 200
+      op::LD_I(0x0050),                // 202
+      op::DRW(regs::V0, regs::V0, 5),  // 204
+      op::LD_I(0x0300),                // 206
+      op::DRW(regs::V0, regs::V0, 5),  // 208
+      op::JP(0x020a),                  // 20a
+  });
+
+  // The first frame shows the whole screen
+  emulator.set_ipf(1);
+  emulator.exec_frame();
+  EXPECT_TRUE(frontend.rows.all());
+
+  emulator.set_ipf(2);
+  emulator.exec_frame();
+  EXPECT_EQ(frontend.rows, std::bitset<chip8::HEIGHT>{0b1'1111'0000});
+
+  // A blank sprite changes nothing
+  emulator.exec_frame();
+  EXPECT_TRUE(frontend.rows.none());
+
+  emulator.exec_frame();
+  EXPECT_TRUE(frontend.rows.none());
+}
@@ -0,0 +1,37 @@
+#include "spsc_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+
+TEST(SpscQueue, BoundedFifo) {
+  auto queue = chip8::spsc_queue<int, 2>{};
+
+  EXPECT_TRUE(queue.push(1));
+  EXPECT_TRUE(queue.push(2));
+  EXPECT_FALSE(queue.push(3));
+
+  EXPECT_EQ(queue.pop(), 1);
+  EXPECT_EQ(queue.pop(), 2);
+  EXPECT_FALSE(queue.pop());
+}
+
+TEST(SpscQueue, KeepsOrderAcrossThreads) {
+  constexpr auto COUNT = std::uint64_t{100'000};
+
+  auto queue = chip8::spsc_queue<std::uint64_t, 64>{};
+
+  auto producer = std::jthread([&] {
+    for (auto value = std::uint64_t{}; value < COUNT; value++) {
+      while (not queue.push(value)) {
+      }
+    }
+  });
+
+  for (auto expected = std::uint64_t{}; expected < COUNT;) {
+    if (auto value = queue.pop()) {
+      ASSERT_EQ(*value, expected++);
+    }
+  }
+}
@@ -0,0 +1,187 @@
+#include "machine_state.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+#include "chip8.h"
+#include "common.h"
+#include "fixture.h"
+
+using State = EmulatorFixture;
+
+namespace {
+// Same layout as machine_state.cpp, the FNV-1a checksum of the state bytes
+// follows magic, version and size
+constexpr auto CHECKSUM_AT = 16UZ;
+constexpr auto STATE_AT = 24UZ;
+
+auto fix_checksum(std::string& data) -> void {
+  auto result = 0xcbf29ce484222325ULL;
+
+  for (auto idx = STATE_AT; idx < data.size(); idx++) {
+    result ^= static_cast<unsigned char>(data.at(idx));
+    result *= 0x100000001b3ULL;
+  }
+
+  data.replace(CHECKSUM_AT, sizeof(result),
+               reinterpret_cast<const char*>(&result), sizeof(result));
+}
+}  // namespace
+
+TEST_F(State, ForkRunsTheSameWay) {
+  emulator.seed(1);
+  fixture::load_drawing(emulator);
+
+  for (auto frame = 0; frame < 10; frame++) {
+    emulator.exec_frame();
+  }
+
+  auto snapshot = emulator.save_state();
+
+  // A second machine on another engine carries on from the snapshot
+  auto fork = chip8::chip8{};
+  fork.set_engine(chip8::engine::cached);
+  fork.load_state(snapshot);
+
+  for (auto frame = 0; frame < 10; frame++) {
+    emulator.exec_frame();
+    fork.exec_frame();
+  }
+
+  EXPECT_EQ(fork.state_hash(), emulator.state_hash());
+  EXPECT_EQ(fork.compare(emulator), std::nullopt);
+
+  // Going back repeats the same frames, RND included
+  auto hash = emulator.state_hash();
+  emulator.load_state(snapshot);
+
+  for (auto frame = 0; frame < 10; frame++) {
+    emulator.exec_frame();
+  }
+
+  EXPECT_EQ(emulator.state_hash(), hash);
+}
+
+TEST_F(State, SavesAndLoads) {
+  emulator.seed(2);
+  fixture::load_drawing(emulator);
+  emulator.exec_n(100);
+
+  auto out = std::stringstream{};
+  chip8::write_state(out, emulator.save_state());
+
+  auto state = chip8::read_state(out);
+  ASSERT_TRUE(state);
+
+  auto other = chip8::chip8{};
+  other.load_state(*state);
+  EXPECT_EQ(other.state_hash(), emulator.state_hash());
+
+  // Other versions are refused
+  auto data = out.str();
+  data.at(4) ^= 0xff;
+
+  auto corrupt = std::stringstream{data};
+  EXPECT_FALSE(chip8::read_state(corrupt));
+}
+
+TEST_F(State, RefusesDamagedStates) {
+  emulator.seed(2);
+  fixture::load_drawing(emulator);
+  emulator.exec_n(100);
+
+  auto out = std::stringstream{};
+  chip8::write_state(out, emulator.save_state());
+
+  // A flipped bit in the state itself
+  auto data = out.str();
+  data.at(data.size() / 2) ^= 0x01;
+
+  auto corrupt = std::stringstream{data};
+  EXPECT_FALSE(chip8::read_state(corrupt));
+
+  // Cut short
+  auto truncated = std::stringstream{out.str().substr(0, out.str().size() - 1)};
+  EXPECT_FALSE(chip8::read_state(truncated));
+
+  // Intact, but out of reach of any program
+  auto state = emulator.save_state();
+  state.pc = 0x2000;
+
+  auto unreachable = std::stringstream{};
+  chip8::write_state(unreachable, state);
+  EXPECT_FALSE(chip8::read_state(unreachable));
+
+  state = emulator.save_state();
+  state.key_wait = static_cast<chip8::keys>(0x20);
+
+  auto bad_key = std::stringstream{};
+  chip8::write_state(bad_key, state);
+  EXPECT_FALSE(chip8::read_state(bad_key));
+}
+
+TEST_F(State, RefusesDamagedKeyWaitFlag) {
+  auto state = emulator.save_state();
+  state.key_wait = chip8::keys::KEY_0;
+
+  auto waiting = std::stringstream{};
+  chip8::write_state(waiting, state);
+
+  // Only the engaged flag changes, the key stays behind
+  state.key_wait.reset();
+
+  auto idle = std::stringstream{};
+  chip8::write_state(idle, state);
+
+  auto data = idle.str();
+  auto flag = std::string::npos;
+
+  for (auto idx = STATE_AT; idx < data.size(); idx++) {
+    if (data.at(idx) != waiting.str().at(idx)) {
+      flag = idx;
+    }
+  }
+
+  ASSERT_NE(flag, std::string::npos);
+
+  data.at(flag) = 0x02;
+  fix_checksum(data);
+
+  auto corrupt = std::stringstream{data};
+  EXPECT_FALSE(chip8::read_state(corrupt));
+
+  // The same edit with a valid flag still loads
+  data.at(flag) = 0x01;
+  fix_checksum(data);
+
+  auto intact = std::stringstream{data};
+  EXPECT_TRUE(chip8::read_state(intact));
+}
+
+TEST_F(State, KeepsCachedCodeOnLoad) {
+  emulator.set_engine(chip8::engine::cached);
+  fixture::load_drawing(emulator);
+
+  auto snapshot = emulator.save_state();
+  emulator.exec_n(100);
+
+  auto invalidations = emulator.get_cache_stats().invalidations;
+  auto misses = emulator.get_cache_stats().misses;
+
+  // Same memory, every block is still good
+  emulator.load_state(snapshot);
+  emulator.exec_n(100);
+
+  EXPECT_EQ(emulator.get_cache_stats().invalidations, invalidations);
+  EXPECT_EQ(emulator.get_cache_stats().misses, misses);
+
+  // Patched code is translated again
+  snapshot.memory.at(0x0200) ^= 0x01;
+  emulator.load_state(snapshot);
+
+  EXPECT_GT(emulator.get_cache_stats().invalidations, invalidations);
+}
@@ -0,0 +1,46 @@
+#include "terminal_frontend.h"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+
+#include "common.h"
+#include "fixture.h"
+#include "instructions.h"
+
+namespace op = chip8::opcode;
+using chip8::regs;
+
+using Terminal = EmulatorFixture;
+
+TEST_F(Terminal, RedrawsChangedCellsOnly) {
+  auto out = std::ostringstream{};
+  auto frontend = chip8::terminal_frontend{out};
+  frontend.set_throttle(false);
+  emulator.set_display(frontend);
+
+  emulator.load_program({
+      op::LD(regs::V0, 0x08),          // 200
+      op::LD_I(0x0050),                // 202
+      op::JP(0x0206),                  // 204
+      op::DRW(regs::V0, regs::V0, 2),  // 206
+      op::JP(0x0208),                  // 208
+  });
+
+  // The first frame clears the terminal and writes every cell
+  emulator.set_ipf(2);
+  emulator.exec_frame();
+  EXPECT_TRUE(out.str().starts_with("\x1b[?25l\x1b[2J"));
+
+  // Nothing changed, nothing written
+  out.str({});
+  emulator.set_ipf(1);
+  emulator.exec_frame();
+  EXPECT_TRUE(out.str().empty());
+
+  // The top two rows of the 0 glyph are 11110000 and 10010000, which
+  // share a cell row
+  emulator.exec_frame();
+  EXPECT_EQ(out.str(), "\x1b[5;9H█▀▀█");
+}
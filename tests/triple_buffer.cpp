@@ -0,0 +1,43 @@
+#include "triple_buffer.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+
+TEST(TripleBuffer, LatestValueWins) {
+  auto buffer = chip8::triple_buffer<int>{};
+  EXPECT_FALSE(buffer.update());
+
+  buffer.back() = 1;
+  buffer.publish();
+  buffer.back() = 2;
+  buffer.publish();
+
+  EXPECT_TRUE(buffer.update());
+  EXPECT_EQ(buffer.front(), 2);
+  EXPECT_FALSE(buffer.update());
+  EXPECT_EQ(buffer.front(), 2);
+}
+
+TEST(TripleBuffer, ConsumerNeverGoesBack) {
+  constexpr auto COUNT = std::uint64_t{100'000};
+
+  auto buffer = chip8::triple_buffer<std::uint64_t>{};
+
+  auto producer = std::jthread([&] {
+    for (auto value = std::uint64_t{1}; value <= COUNT; value++) {
+      buffer.back() = value;
+      buffer.publish();
+    }
+  });
+
+  auto last = std::uint64_t{};
+
+  while (last != COUNT) {
+    if (buffer.update()) {
+      ASSERT_GT(buffer.front(), last);
+      last = buffer.front();
+    }
+  }
+}
@@ -0,0 +1,74 @@
+#include "video.h"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+
+#include "common.h"
+#include "fixture.h"
+#include "instructions.h"
+
+namespace op = chip8::opcode;
+using chip8::regs;
+
+using Video = EmulatorFixture;
+
+TEST(VideoPack, LeftmostPixelFirst) {
+  auto value = chip8::screen{};
+  value[0, 0] = true;
+  value[9, 0] = true;
+  value[63, 31] = true;
+
+  auto packed = chip8::video_writer::pack(value);
+  EXPECT_EQ(packed.at(0), 0x80);
+  EXPECT_EQ(packed.at(1), 0x40);
+  EXPECT_EQ(packed.back(), 0x01);
+}
+
+TEST_F(Video, RawRepeatsUnchangedFrames) {
+  auto out = std::ostringstream{};
+
+  emulator.load_program({
+      op::LD_I(0x0050),                // 200
+      op::DRW(regs::V0, regs::V0, 5),  // 202
+      op::JP(0x0204),                  // 204
+  });
+  emulator.set_ipf(2);
+
+  {
+    auto writer = chip8::video_writer{out, chip8::video_format::raw};
+    emulator.set_display(writer);
+
+    for (auto frame = 0; frame < 3; frame++) {
+      emulator.exec_frame();
+    }
+
+    EXPECT_EQ(writer.frames(), 3);
+    EXPECT_EQ(writer.repeats(), 2);
+  }
+
+  auto data = out.str();
+  ASSERT_EQ(data.size(), 1 + chip8::video_writer::FRAME_SIZE + 2);
+  EXPECT_EQ(data.front(), 'F');
+  EXPECT_EQ(data.substr(data.size() - 2), "RR");
+}
+
+TEST_F(Video, Y4mWritesEveryFrame) {
+  auto out = std::ostringstream{};
+
+  {
+    auto writer = chip8::video_writer{out, chip8::video_format::y4m};
+    emulator.set_display(writer);
+
+    emulator.exec_frame();
+    emulator.exec_frame();
+  }
+
+  auto header = std::string{"YUV4MPEG2 W64 H32 F60:1 Ip A1:1 Cmono\n"};
+  auto frame = std::string{"FRAME\n"}.size() + (chip8::WIDTH * chip8::HEIGHT);
+
+  auto data = out.str();
+  EXPECT_TRUE(data.starts_with(header));
+  EXPECT_EQ(data.size(), header.size() + (2 * frame));
+}